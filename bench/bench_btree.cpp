@@ -0,0 +1,89 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include "tiny_set.h"
+#include "tiny_btree_set.h"
+
+// usage: bench_btree [max_keys]
+// random 64-bit keys from 1K up to max_keys (default 10M; 100M needs
+// several GB for the red-black tree), reported as ns per operation
+
+using namespace Tiny;
+using clock_type = std::chrono::steady_clock;
+
+template <typename Function>
+double run(Function f)
+{
+    auto start = clock_type::now();
+    f();
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    return elapsed.count() * 1e9;
+}
+
+static std::vector<uint64_t> random_keys(size_t n, uint64_t seed)
+{
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+        keys[i] = seed;
+    }
+    return keys;
+}
+
+template <typename Set>
+static void bench(const char* name, const std::vector<uint64_t>& keys,
+                  const std::vector<uint64_t>& probes)
+{
+    size_t n = keys.size();
+    Set s;
+    double insert_ns = run([&] {
+        for (uint64_t k : keys)
+            s.insert(k);
+    });
+
+    size_t found = 0;
+    double find_ns = run([&] {
+        for (uint64_t k : probes)
+            found += s.find(k) != s.end();
+    });
+
+    uint64_t sum = 0;
+    double iterate_ns = run([&] {
+        for (auto it = s.begin(); it != s.end(); ++it)
+            sum += *it;
+    });
+
+    double erase_ns = run([&] {
+        for (size_t i = 0; i < n; i += 2)
+            s.erase(keys[i]);
+    });
+
+    std::cout << std::setw(12) << name << std::fixed << std::setprecision(1)
+              << std::setw(10) << insert_ns / n
+              << std::setw(10) << find_ns / probes.size()
+              << std::setw(10) << iterate_ns / n
+              << std::setw(10) << erase_ns / ((n + 1) / 2)
+              << "   (found " << found << ", sum " << (sum & 0xffff) << ')' << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t max_keys = argc > 1 ? atol(argv[1]) : 10000000;
+    std::cout << "btree_set: " << btree<uint64_t, uint64_t, identity<uint64_t>,
+                 std::less<uint64_t>>::node_values << " keys per node" << std::endl;
+    for (size_t n = 1000; n <= max_keys; n *= 10) {
+        std::vector<uint64_t> keys = random_keys(n, 88172645463325252ULL);
+        // half hits, half misses
+        std::vector<uint64_t> probes = random_keys(n, 2463534242ULL);
+        for (size_t i = 0; i < n; i += 2)
+            probes[i] = keys[(i * 7) % n];
+
+        std::cout << "keys = " << n << std::setw(10) << "insert" << std::setw(10) << "find"
+                  << std::setw(10) << "iterate" << std::setw(10) << "erase" << "  ns/op" << std::endl;
+        bench<set<uint64_t>>("rb_tree", keys, probes);
+        bench<btree_set<uint64_t>>("btree", keys, probes);
+    }
+}
@@ -0,0 +1,103 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <cstdlib>
+#include <cstdint>
+#include "tiny_concurrent_map.h"
+#include "tiny_map.h"
+
+// usage: bench_concurrent_map [keys] [max_readers]
+// readers look up random keys while one writer keeps inserting and erasing;
+// lookups in Mops/s summed over the readers, then the writer's updates
+
+using namespace Tiny;
+using clock_type = std::chrono::steady_clock;
+
+class locked_map
+{
+    mutable std::shared_mutex m;
+    map<uint64_t, uint64_t> t;
+
+public:
+    void insert(const std::pair<const uint64_t, uint64_t>& x) {
+        std::unique_lock<std::shared_mutex> lock(m);
+        t.insert(x);
+    }
+    void erase(uint64_t k) {
+        std::unique_lock<std::shared_mutex> lock(m);
+        auto it = t.find(k);
+        if (it != t.end()) t.erase(it);
+    }
+    size_t count(uint64_t k) const {
+        std::shared_lock<std::shared_mutex> lock(m);
+        return t.count(k);
+    }
+};
+
+template <typename Map>
+std::pair<double, double> run(Map& m, uint64_t keys, int readers)
+{
+    const long lookups = 1000000;
+    std::atomic<bool> done(false);
+    long updates = 0;
+    std::thread writer([&m, &done, &updates, keys] {
+        uint64_t seed = 88172645463325252ULL;
+        while (!done.load(std::memory_order_relaxed)) {
+            seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+            uint64_t k = seed % keys;
+            if (seed & 1 << 20)
+                m.insert(std::pair<const uint64_t, uint64_t>(k, k));
+            else
+                m.erase(k);
+            updates++;
+        }
+    });
+    std::vector<std::thread> workers;
+    std::atomic<size_t> found(0);
+    auto start = clock_type::now();
+    for (int t = 0; t < readers; t++)
+        workers.emplace_back([&m, &found, keys, t] {
+            uint64_t seed = 2463534242ULL + t;
+            size_t local = 0;
+            for (long i = 0; i < lookups; i++) {
+                seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+                local += m.count(seed % keys);
+            }
+            found += local;
+        });
+    for (auto& w : workers)
+        w.join();
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    done = true;
+    writer.join();
+    return std::make_pair(lookups * readers / elapsed.count() / 1e6, updates / elapsed.count() / 1e6);
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t keys = argc > 1 ? atol(argv[1]) : 100000;
+    int max_readers = argc > 2 ? atoi(argv[2]) : 16;
+
+    std::cout << "keys = " << keys << ", Mops/s" << std::endl;
+    std::cout << std::setw(8) << "readers" << std::setw(24) << "concurrent_map"
+              << std::setw(24) << "shared_mutex+map" << std::endl;
+    for (int readers = 1; readers <= max_readers; readers *= 2)
+    {
+        concurrent_map<uint64_t, uint64_t> lock_free;
+        locked_map locked;
+        for (uint64_t k = 0; k < keys; k += 2) {
+            lock_free.insert(std::pair<const uint64_t, uint64_t>(k, k));
+            locked.insert(std::pair<const uint64_t, uint64_t>(k, k));
+        }
+        std::pair<double, double> a = run(lock_free, keys, readers);
+        std::pair<double, double> b = run(locked, keys, readers);
+        std::cout << std::setw(8) << readers << std::fixed << std::setprecision(2)
+                  << std::setw(12) << a.first << std::setw(12) << a.second
+                  << std::setw(12) << b.first << std::setw(12) << b.second << std::endl;
+    }
+}
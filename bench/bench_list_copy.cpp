@@ -0,0 +1,76 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <list>
+#include <cstdlib>
+#include "tiny_list.h"
+
+// usage: bench_list_copy [nodes]
+
+using namespace Tiny;
+using clock_type = std::chrono::steady_clock;
+
+template <typename Function>
+double run(Function f)
+{
+    auto start = clock_type::now();
+    f();
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    return elapsed.count() * 1e3;
+}
+
+static void report(const char* name, double ms, size_t check)
+{
+    std::cout << std::setw(24) << name << std::fixed << std::setprecision(1)
+              << std::setw(12) << ms << " ms" << "   (size " << check << ')' << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    long nodes = argc > 1 ? atol(argv[1]) : 10000000L;
+    list<int> src;
+    std::list<int> std_src;
+    for (long i = 0; i < nodes; i++) {
+        src.push_back(int(i));
+        std_src.push_back(int(i));
+    }
+
+    std::cout << "nodes = " << nodes << std::endl;
+    size_t n = 0;
+    double ms;
+
+    ms = run([&] {
+        list<int> dst;
+        for (auto it = src.begin(); it != src.end(); ++it)
+            dst.push_back(*it);
+        n = dst.size();
+    });
+    report("push_back loop", ms, n);
+
+    ms = run([&] {
+        list<int> dst(src);
+        n = dst.size();
+    });
+    report("copy constructor", ms, n);
+
+    list<int> reused(src);
+    reused.resize(nodes / 2);
+    ms = run([&] {
+        reused = src;
+        n = reused.size();
+    });
+    report("operator= (half reused)", ms, n);
+
+    ms = run([&] {
+        list<int> dst;
+        dst.resize(nodes, 1);
+        n = dst.size();
+    });
+    report("resize", ms, n);
+
+    ms = run([&] {
+        std::list<int> dst(std_src);
+        n = dst.size();
+    });
+    report("std::list copy", ms, n);
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <cstdlib>
+#include "tiny_mpmc_queue.h"
+#include "tiny_queue.h"
+
+// usage: bench_mpmc_queue [total_items] [max_threads_per_side]
+
+using namespace Tiny;
+using clock_type = std::chrono::steady_clock;
+
+class locked_queue
+{
+    std::mutex m;
+    queue<int> q;
+
+public:
+    bool try_push(int x) {
+        std::lock_guard<std::mutex> lock(m);
+        q.push(x);
+        return true;
+    }
+    bool try_pop(int& x) {
+        std::lock_guard<std::mutex> lock(m);
+        if (q.empty()) return false;
+        x = q.front();
+        q.pop();
+        return true;
+    }
+};
+
+template <typename Queue>
+double run(Queue& q, int threads, long items)
+{
+    long per_thread = items / threads;
+    std::vector<std::thread> workers;
+    auto start = clock_type::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&q, per_thread] {
+            for (long i = 0; i < per_thread; i++)
+                while (!q.try_push(int(i)))
+                    std::this_thread::yield();
+        });
+        workers.emplace_back([&q, per_thread] {
+            int x;
+            for (long i = 0; i < per_thread; i++)
+                while (!q.try_pop(x))
+                    std::this_thread::yield();
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    return per_thread * threads / elapsed.count() / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    long items = argc > 1 ? atol(argv[1]) : 1L << 22;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 64;
+
+    std::cout << "items = " << items << ", Mops/s" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "mpmc_queue"
+              << std::setw(14) << "mutex+queue" << std::endl;
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        mpmc_queue<int> lock_free(1024);
+        locked_queue locked;
+        double a = run(lock_free, threads, items);
+        double b = run(locked, threads, items);
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+                  << std::setw(14) << a << std::setw(14) << b << std::endl;
+    }
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include "tiny_set.h"
+
+// usage: bench_set_ops [n]
+// union and intersection of an n-key set (default 1M) with sets of m keys,
+// element by element against the join-based bulk operations; ms per call
+
+using namespace Tiny;
+using clock_type = std::chrono::steady_clock;
+using key_set = set<uint64_t>;
+
+template <typename Function>
+double run(Function f)
+{
+    auto start = clock_type::now();
+    f();
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    return elapsed.count() * 1e3;
+}
+
+static key_set random_set(size_t n, uint64_t seed)
+{
+    key_set s;
+    for (size_t i = 0; i < n; i++) {
+        seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+        // a small key space so the sets overlap
+        s.insert(seed % (4 * n + 1000000));
+    }
+    return s;
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = argc > 1 ? atol(argv[1]) : 1000000;
+    key_set big = random_set(n, 88172645463325252ULL);
+    std::cout << std::setw(10) << "m" << std::setw(14) << "insert loop" << std::setw(12) << "set_union"
+              << std::setw(14) << "find loop" << std::setw(18) << "set_intersection" << std::endl;
+    for (size_t m = 1000; m <= n; m *= 10) {
+        key_set small = random_set(m, 2463534242ULL + m);
+
+        key_set a = big, b = small;
+        double insert_ms = run([&] {
+            for (uint64_t k : b)
+                a.insert(k);
+        });
+        size_t union_size = a.size();
+        a = big;
+        double union_ms = run([&] { a.set_union(b); });
+        if (a.size() != union_size) std::cout << "union size mismatch" << std::endl;
+
+        // both sides pay for freeing the dropped nodes of a
+        a = big, b = small;
+        key_set found;
+        double find_ms = run([&] {
+            for (uint64_t k : b)
+                if (a.find(k) != a.end())
+                    found.insert(found.end(), k);
+            a.swap(found);
+            found.clear();
+        });
+        size_t intersection_size = a.size();
+        a = big, b = small;
+        double intersection_ms = run([&] { a.set_intersection(b); });
+        if (a.size() != intersection_size) std::cout << "intersection size mismatch" << std::endl;
+
+        std::cout << std::setw(10) << m << std::fixed << std::setprecision(2)
+                  << std::setw(14) << insert_ms << std::setw(12) << union_ms
+                  << std::setw(14) << find_ms << std::setw(18) << intersection_ms << std::endl;
+    }
+}
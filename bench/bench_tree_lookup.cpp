@@ -0,0 +1,83 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include "tiny_set.h"
+
+// usage: bench_tree_lookup [max_keys]
+// random 64-bit keys from 1K up to max_keys (default 10M; 100M needs about
+// 5 GB), half hits and half misses, reported as ns per lookup
+
+using namespace Tiny;
+using clock_type = std::chrono::steady_clock;
+using key_set = set<uint64_t>;
+
+template <typename Function>
+double run(Function f)
+{
+    auto start = clock_type::now();
+    f();
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    return elapsed.count() * 1e9;
+}
+
+static std::vector<uint64_t> random_keys(size_t n, uint64_t seed)
+{
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+        keys[i] = seed;
+    }
+    return keys;
+}
+
+int main(int argc, char** argv)
+{
+    size_t max_keys = argc > 1 ? atol(argv[1]) : 10000000;
+    const size_t probe_count = 1000000;
+    std::cout << std::setw(12) << "keys" << std::setw(10) << "find" << std::setw(14) << "lower_bound"
+              << std::setw(12) << "find_many" << std::endl;
+    for (size_t n = 1000; n <= max_keys; n *= 10) {
+        key_set s;
+        std::vector<uint64_t> probes = random_keys(probe_count, 2463534242ULL);
+        {
+            std::vector<uint64_t> keys = random_keys(n, 88172645463325252ULL);
+            for (uint64_t k : keys)
+                s.insert(k);
+            for (size_t i = 0; i < probe_count / 2; i++)
+                probes[i] = keys[probes[i] % n];
+        }
+        for (size_t i = probes.size() - 1; i > 0; i--)
+            std::swap(probes[i], probes[probes[i] % (i + 1)]);
+
+        size_t found = 0;
+        double find_ns = run([&] {
+            for (uint64_t k : probes)
+                found += s.find(k) != s.end();
+        });
+
+        uint64_t sum = 0;
+        double lower_ns = run([&] {
+            for (uint64_t k : probes) {
+                auto it = s.lower_bound(k);
+                sum += it != s.end() ? *it : 0;
+            }
+        });
+
+        std::vector<key_set::iterator> results(probes.size());
+        double many_ns = run([&] {
+            s.find_many(probes.begin(), probes.end(), results.begin());
+        });
+        size_t found_many = 0;
+        for (auto it : results)
+            found_many += it != s.end();
+
+        std::cout << std::setw(12) << n << std::fixed << std::setprecision(1)
+                  << std::setw(10) << find_ns / probes.size()
+                  << std::setw(14) << lower_ns / probes.size()
+                  << std::setw(12) << many_ns / probes.size()
+                  << "   (found " << found << '/' << found_many << ", sum " << (sum & 0xffff) << ')' << std::endl;
+    }
+}
@@ -0,0 +1,61 @@
+#include "tiny_btree_set.h"
+#include "tiny_btree_map.h"
+#include <iostream>
+#include <string>
+
+int main(void)
+{
+    using namespace std;
+    Tiny::btree_set<int> s;
+    for (int i = 0; i < 1000; i++)
+        s.insert((i * 7919) % 1000);
+    cout << "size = " << s.size() << ", insert 5 again: " << s.insert(5).second << endl;
+    cout << "*lower_bound(500) = " << *s.lower_bound(500)
+         << ", find(1000) == end: " << (s.find(1000) == s.end()) << endl;
+    for (int i = 0; i < 1000; i += 2)
+        s.erase(i);
+    cout << "size = " << s.size() << ", first five:";
+    auto it = s.begin();
+    for (int i = 0; i < 5; i++)
+        cout << ' ' << *it++;
+    cout << ", last: " << *--s.end() << endl;
+
+    Tiny::btree_multiset<int> ms(s.begin(), s.end());
+    for (int i = 0; i < 100; i++)
+        ms.insert(i % 3);
+    cout << "count(1) = " << ms.count(1) << ", count(2) = " << ms.count(2) << endl;
+    cout << "erase(1) = " << ms.erase(1) << ", size = " << ms.size() << endl;
+
+    // erase hands back the successor, so the usual filtering loop works
+    Tiny::btree_multiset<int> big;
+    for (int i = 0; i < 10000; i++)
+        big.insert(i % 2500);
+    for (auto p = big.begin(); p != big.end(); )
+        if (*p % 3 == 0)
+            p = big.erase(p);
+        else
+            ++p;
+    cout << "after filtering size = " << big.size() << ", count(3) = " << big.count(3)
+         << ", count(4) = " << big.count(4) << endl;
+
+    Tiny::btree_map<string, int> m;
+    const char* words[] = { "pear", "apple", "fig", "apple", "kiwi", "fig", "apple" };
+    for (const char* w : words)
+        m[w]++;
+    for (auto p = m.begin(); p != m.end(); ++p)
+        cout << p->first << ':' << p->second << ' ';
+    cout << endl;
+
+    Tiny::btree_multimap<int, string> mm;
+    mm.insert(make_pair(2, string("b")));
+    mm.insert(make_pair(1, string("a")));
+    mm.insert(make_pair(2, string("c")));
+    auto range = mm.equal_range(2);
+    for (auto p = range.first; p != range.second; ++p)
+        cout << p->first << p->second << ' ';
+    cout << endl;
+
+    Tiny::btree_map<string, int> copy = m;
+    copy.erase("apple");
+    cout << "copy size = " << copy.size() << ", original size = " << m.size() << endl;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include "tiny_circular_buffer.h"
+#include "tiny_queue.h"
+#include "tiny_stack.h"
+
+using namespace Tiny;
+using std::cout;
+using std::endl;
+
+int main(void)
+{
+    circular_buffer<int> cb(5);
+    cout << "capacity = " << cb.capacity() << endl;
+
+    for (int i = 0; i < 10; i++)
+        cb.push_back(i);
+    cout << "size = " << cb.size() << endl;
+    for (auto it = cb.begin(); it != cb.end(); it++)
+        cout << *it << ' ';
+    cout << endl;
+
+    auto one = cb.array_one();
+    auto two = cb.array_two();
+    cout << "array_one = " << one.second << ", array_two = " << two.second << endl;
+    for (size_t i = 0; i < one.second; i++)
+        cout << one.first[i] << ' ';
+    for (size_t i = 0; i < two.second; i++)
+        cout << two.first[i] << ' ';
+    cout << endl;
+
+    circular_buffer<int> bounded(4, cb_reject);
+    for (int i = 0; i < 6; i++)
+        cout << bounded.push_back(i) << ' ';
+    cout << endl;
+    bounded.pop_front();
+    bounded.push_front(99);
+    for (size_t i = 0; i < bounded.size(); i++)
+        cout << bounded[i] << ' ';
+    cout << endl;
+
+    queue<int, circular_buffer<int>> window(circular_buffer<int>(4));
+    for (int i = 0; i < 7; i++)
+        window.push(i);
+    cout << "front = " << window.front() << ", back = " << window.back() << endl;
+    window.pop();
+    cout << "size = " << window.size() << endl;
+
+    circular_buffer<std::string> names(3);
+    for (const char* x : { "a", "b", "c", "d", "e" })
+        names.push_back(x);
+    names.push_front("z");
+    for (auto& x : names)
+        cout << x << ' ';
+    cout << "(size = " << names.size() << ")" << endl;
+    circular_buffer<std::string> copy(names);
+    names.clear();
+    cout << "copy.front = " << copy.front() << ", names.empty = " << names.empty() << endl;
+
+    stack<int, circular_buffer<int>> s;
+    s.push(1);
+    s.push(2);
+    cout << "top = " << s.top() << endl;
+    s.pop();
+    cout << "top = " << s.top() << endl;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "tiny_concurrent_map.h"
+
+using namespace Tiny;
+using std::cout;
+using std::endl;
+
+int main(void)
+{
+    concurrent_map<int, std::string> m;
+    m.insert(std::make_pair(3, std::string("three")));
+    m.insert(std::make_pair(1, std::string("one")));
+    m.insert(std::make_pair(4, std::string("four")));
+    m.insert(std::make_pair(2, std::string("two")));
+    cout << "insert again = " << m.insert(std::make_pair(2, std::string("deux"))).second << endl;
+    for (auto& x : m)
+        cout << x.first << ' ' << x.second << ", ";
+    cout << endl;
+    cout << "size = " << m.size() << endl;
+
+    auto it = m.find(3);
+    cout << "find(3) = " << it->second << endl;
+    cout << "find(5) == end: " << (m.find(5) == m.end()) << endl;
+    cout << "lower_bound(2) = " << m.lower_bound(2)->first << endl;
+    cout << "upper_bound(2) = " << m.upper_bound(2)->first << endl;
+    cout << "erase(3) = " << m.erase(3) << ", erase(3) = " << m.erase(3) << endl;
+    // the iterator still pins the erased element
+    cout << "erased element = " << it->second << endl;
+    for (auto& x : m)
+        cout << x.first << ' ';
+    cout << endl;
+    m.clear();
+    cout << "empty = " << m.empty() << endl;
+
+    // writers insert and erase disjoint key ranges while readers scan
+    concurrent_map<int, int> c;
+    const int writers = 2;
+    const int keys = 20000;
+    std::atomic<bool> done(false);
+    std::atomic<long long> scans(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; t++)
+        readers.emplace_back([&c, &done, &scans] {
+            bool ordered = true;
+            while (!done.load()) {
+                int prev = -1;
+                for (auto& x : c) {
+                    if (x.first <= prev or x.second != x.first * 2) ordered = false;
+                    prev = x.first;
+                }
+                c.count(prev);
+                scans++;
+            }
+            if (!ordered) cout << "reader saw a broken order" << endl;
+        });
+    std::vector<std::thread> workers;
+    for (int t = 0; t < writers; t++)
+        workers.emplace_back([&c, t] {
+            for (int round = 0; round < 3; round++) {
+                for (int i = t; i < keys; i += writers)
+                    c.insert(std::make_pair(i, i * 2));
+                for (int i = t; i < keys; i += 2 * writers)
+                    c.erase(i);
+            }
+        });
+    for (auto& w : workers)
+        w.join();
+    done = true;
+    for (auto& r : readers)
+        r.join();
+
+    int expected = 0;
+    for (int i = 0; i < keys; i++)
+        expected += i % (2 * writers) >= writers;
+    int present = 0;
+    for (auto& x : c)
+        present += x.first % (2 * writers) >= writers;
+    cout << "size = " << c.size() << ", expected = " << expected << ", present = " << present << endl;
+    cout << "scans > 0: " << (scans > 0) << endl;
+}
@@ -31,4 +31,23 @@ int main(void)
         cout << ideq[i] << ' ';
     cout << endl;
     cout << "size = " << ideq.size() << endl; 
-}
\ No newline at end of file
+
+    deque<int, alloc, 32> big(100, 1);
+    Tiny::fill(big.begin() + 10, big.end() - 10, 2);
+    cout << "count of 2 = " << Tiny::count(big.begin(), big.end(), 2) << endl;
+    cout << "sum = " << Tiny::accumulate(big.begin(), big.end(), 0) << endl;
+    for (int i = 0; i < big.size(); i++)
+        big[i] = i;
+    cout << "find 70 at " << Tiny::find(big.begin(), big.end(), 70) - big.begin() << endl;
+    
+    int arr[100];
+    Tiny::copy(big.begin(), big.end(), arr);
+    cout << "arr[99] = " << arr[99] << endl;
+    Tiny::copy(big.begin() + 50, big.end(), big.begin());
+    Tiny::copy_backward(big.begin(), big.begin() + 50, big.end());
+    cout << big[0] << ' ' << big[49] << ' ' << big[50] << ' ' << big[99] << endl;
+    
+    big.erase(big.begin() + 5);
+    big.erase(big.begin() + 80);
+    cout << "size = " << big.size() << endl;
+}
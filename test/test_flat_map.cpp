@@ -0,0 +1,38 @@
+#include "tiny_flat_map.h"
+#include <iostream>
+#include <string>
+
+int main(void)
+{
+    using namespace std;
+    Tiny::flat_map<string, int> routes;
+    routes.reserve(8);
+    routes["/users"] = 3;
+    routes["/admin"] = 1;
+    routes["/login"] = 2;
+    cout << "insert /admin again: " << routes.insert(make_pair(string("/admin"), 9)).second << endl;
+
+    pair<string, int> batch[] = { { "/static", 5 }, { "/api", 4 }, { "/login", 7 }, { "/api", 6 } };
+    routes.insert(batch, batch + 4);
+    for (auto it = routes.begin(); it != routes.end(); ++it)
+        cout << it->first << '=' << it->second << ' ';
+    cout << endl;
+
+    routes.find("/users")->second = 30;
+    cout << "/users = " << routes["/users"] << ", count(/none) = " << routes.count("/none")
+         << ", size = " << routes.size() << endl;
+    routes.erase("/admin");
+    cout << "first = " << (*routes.begin()).first << ", distance = "
+         << Tiny::distance(routes.begin(), routes.end()) << endl;
+
+    Tiny::flat_multimap<int, char> mm;
+    mm.insert(make_pair(2, 'b'));
+    mm.insert(make_pair(1, 'a'));
+    mm.insert(make_pair(2, 'c'));
+    pair<int, char> more[] = { { 2, 'd' }, { 0, 'z' } };
+    mm.insert(more, more + 2);
+    auto range = mm.equal_range(2);
+    for (auto it = range.first; it != range.second; ++it)
+        cout << it->first << it->second << ' ';
+    cout << "| size = " << mm.size() << endl;
+}
@@ -0,0 +1,37 @@
+#include "tiny_flat_set.h"
+#include <iostream>
+
+int main(void)
+{
+    using namespace std;
+    Tiny::flat_set<int> s;
+    s.reserve(16);
+    for (int x : { 5, 1, 4, 1, 3 })
+        s.insert(x);
+    cout << "size = " << s.size() << ", capacity = " << s.capacity() << endl;
+
+    int batch[] = { 9, 2, 4, 8, 2, 7 };
+    s.insert(batch, batch + 6);
+    for (int x : s)
+        cout << x << ' ';
+    cout << endl;
+
+    cout << "*lower_bound(6) = " << *s.lower_bound(6)
+         << ", find(6) == end: " << (s.find(6) == s.end())
+         << ", count(4) = " << s.count(4) << endl;
+    s.erase(4);
+    s.erase(s.begin());
+    cout << "size = " << s.size() << ", front = " << *s.begin() << endl;
+
+    Tiny::flat_multiset<int> ms(batch, batch + 6);
+    ms.insert(2);
+    ms.insert(batch, batch + 3);
+    cout << "count(2) = " << ms.count(2) << ", count(9) = " << ms.count(9) << endl;
+    for (int x : ms)
+        cout << x << ' ';
+    cout << endl;
+
+    Tiny::flat_multiset<int> copy = ms;
+    copy.erase(2);
+    cout << "copy size = " << copy.size() << ", original size = " << ms.size() << endl;
+}
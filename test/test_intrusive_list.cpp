@@ -0,0 +1,76 @@
+#include <iostream>
+#include <string>
+#include "tiny_intrusive_list.h"
+
+using namespace Tiny;
+using std::cout;
+using std::endl;
+
+struct connection
+{
+    int id;
+    std::string peer;
+    intrusive_list_hook lru;
+    intrusive_list_hook timer;
+
+    connection(int i, const std::string& p) : id(i), peer(p) { }
+};
+
+using lru_list = intrusive_list<connection, &connection::lru>;
+using timer_list = intrusive_list<connection, &connection::timer>;
+
+template <typename List>
+void print(const List& l)
+{
+    for (auto it = l.begin(); it != l.end(); ++it)
+        cout << it->id << ':' << it->peer << ' ';
+    cout << "(size = " << l.size() << ')' << endl;
+}
+
+int main(void)
+{
+    connection pool[5] = {
+        { 0, "a" }, { 1, "b" }, { 2, "c" }, { 3, "d" }, { 4, "e" }
+    };
+
+    lru_list lru;
+    timer_list timers;
+    for (auto& c : pool) {
+        lru.push_back(c);
+        timers.push_front(c);
+    }
+    print(lru);
+    print(timers);
+
+    // touch 2: move it to the front of the LRU list in O(1)
+    lru.splice(lru.begin(), lru, lru_list::iterator_to(pool[2]));
+    print(lru);
+
+    // close 3: unlink it from both lists without searching
+    lru.erase(pool[3]);
+    timers.erase(pool[3]);
+    cout << "3 linked = " << pool[3].lru.is_linked() << pool[3].timer.is_linked() << endl;
+    print(lru);
+    print(timers);
+
+    lru.pop_back();
+    cout << "front = " << lru.front().id << ", back = " << lru.back().id << endl;
+
+    connection copy = pool[0];
+    cout << "copy linked = " << copy.lru.is_linked() << endl;
+
+    lru_list other;
+    other.push_back(copy);
+    other.swap(lru);
+    print(lru);
+    print(other);
+
+    lru_list moved(std::move(other));
+    print(moved);
+    cout << "other empty = " << other.empty() << endl;
+
+    moved.clear();
+    lru.clear();
+    timers.clear();
+    cout << "0 linked = " << pool[0].lru.is_linked() << endl;
+}
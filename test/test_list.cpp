@@ -1,4 +1,5 @@
 #include <iostream>
+#include <stdexcept>
 #include "tiny_list.h"
 
 using namespace Tiny;
@@ -6,6 +7,29 @@ using std::cout;
 using std::endl;
 using std::cin;
 
+struct fussy_less
+{
+    static int left;
+    bool operator()(int a, int b) const {
+        if (left >= 0 and left-- == 0) throw std::runtime_error("compare");
+        return a < b;
+    }
+};
+int fussy_less::left = -1;
+
+// walks l both ways and sums it, so a broken link shows up
+template <typename List>
+long long checked_sum(const List& l)
+{
+    long long sum = 0;
+    size_t forward = 0, backward = 0;
+    for (auto it = l.begin(); it != l.end(); ++it, forward++)
+        sum += *it;
+    for (auto it = l.end(); it != l.begin(); --it)
+        backward++;
+    return forward == l.size() and backward == l.size() ? sum : -1;
+}
+
 int main(void)
 {
     list<int> ilist;
@@ -21,4 +45,86 @@ int main(void)
     for (auto it = ilist.begin(); it != ilist.end(); it++)
         cout << *it << ' ';
     cout << endl;
+
+    list<int> other;
+    for (int i = 10; i < 15; i++)
+        other.push_back(i);
+    ilist.splice(ilist.begin(), other, other.begin());
+    cout << "size = " << ilist.size() << ", other size = " << other.size() << endl;
+    ilist.splice(ilist.end(), other, other.begin(), other.end());
+    cout << "size = " << ilist.size() << ", other size = " << other.size() << endl;
+
+    ilist.push_back(2);
+    ilist.push_back(2);
+    ilist.remove(3);
+    ilist.sort();
+    ilist.unique();
+    cout << "size = " << ilist.size() << endl;
+    for (auto it = ilist.begin(); it != ilist.end(); it++)
+        cout << *it << ' ';
+    cout << endl;
+
+    other.push_back(5);
+    other.push_back(100);
+    ilist.merge(other);
+    cout << "size = " << ilist.size() << ", other size = " << other.size() << endl;
+    ilist.clear();
+    cout << "size = " << ilist.size() << endl;
+
+    for (int i = 0; i < 10; i++)
+        ilist.push_back((i * 7) % 10);
+    ilist.sort(std::greater<int>());
+    for (auto it = ilist.begin(); it != ilist.end(); it++)
+        cout << *it << ' ';
+    cout << endl;
+
+    list<int> big;
+    for (int i = 0; i < 200000; i++)
+        big.push_back((i * 7919) % 200000);
+    big.parallel_sort();
+    int expect = 0;
+    bool sorted = true;
+    for (auto it = big.begin(); it != big.end(); it++)
+        sorted = sorted and *it == expect++;
+    cout << "parallel_sort sorted = " << sorted << ", size = " << big.size() << endl;
+
+    // a throwing compare leaves the list linked with every element
+    list<int> shuffled;
+    for (int i = 0; i < 1000; i++)
+        shuffled.push_back((i * 7919) % 1000);
+    fussy_less::left = 50;
+    try {
+        shuffled.sort(fussy_less());
+    }
+    catch (const std::runtime_error&) {
+        cout << "sort threw, size = " << shuffled.size() << ", sum = " << checked_sum(shuffled) << endl;
+    }
+    big.reverse();
+    fussy_less::left = 300000;
+    try {
+        big.parallel_sort(fussy_less());
+    }
+    catch (const std::runtime_error&) {
+        cout << "parallel_sort threw, size = " << big.size() << ", sum = " << checked_sum(big) << endl;
+    }
+    fussy_less::left = -1;
+
+    int arr[] = { 1, 2, 3, 4, 5 };
+    list<int> range(arr, arr + 5);
+    list<int> copy(range);
+    copy.insert(++copy.begin(), 3, 9);
+    copy.insert(copy.end(), arr, arr + 2);
+    for (auto it = copy.begin(); it != copy.end(); it++)
+        cout << *it << ' ';
+    cout << "(size = " << copy.size() << ')' << endl;
+
+    range = copy;
+    range.resize(4);
+    range.resize(6, 7);
+    for (auto it = range.begin(); it != range.end(); it++)
+        cout << *it << ' ';
+    cout << "(size = " << range.size() << ')' << endl;
+    range.assign(2, 8);
+    copy.assign(range.begin(), range.end());
+    cout << "copy size = " << copy.size() << ", front = " << copy.front() << endl;
 }
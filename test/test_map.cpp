@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include "tiny_map.h"
+#include "tiny_vector.h"
 
 int main(void)
 {
@@ -29,4 +31,51 @@ int main(void)
     it->second = 9;
     num = h["jerry"];
     std::cout << num << std::endl;
-}
\ No newline at end of file
+
+    Tiny::map<int, int> seq;
+    for (int i = 0; i < 1000; i++)
+        seq.insert(seq.end(), std::pair<int, int>(i, i * i));
+    auto hint = seq.find(500);
+    seq.insert(hint, std::pair<int, int>(500, 0));
+    seq.insert(hint, std::pair<int, int>(-1, 1));
+    std::cout << "size = " << seq.size() << ", begin = " << seq.begin()->first
+              << ", 500 -> " << seq[500] << std::endl;
+
+    Tiny::map<int, int> shard_a, shard_b;
+    for (int i = 0; i < 10; i++)
+        shard_a[i] = i * 10;
+    shard_b[3] = -3;
+    auto node = shard_a.extract(7);
+    node.value().second = 77;
+    shard_b.insert(std::move(node));
+    std::cout << "extracted: " << node.empty() << ", b[7] = " << shard_b[7] << std::endl;
+    shard_b.merge(shard_a);
+    std::cout << "a size = " << shard_a.size() << " (left " << shard_a.begin()->first
+              << "), b size = " << shard_b.size() << ", b[3] = " << shard_b[3] << std::endl;
+
+    Tiny::map<std::string, int, std::less<>> routes;
+    routes["/index"] = 1;
+    routes["/login"] = 2;
+    const char* path = "/login";
+    std::cout << "find(const char*) -> " << routes.find(path)->second
+              << ", count(\"/none\") = " << routes.count("/none")
+              << ", lower_bound(\"/j\") -> " << routes.lower_bound("/j")->first << std::endl;
+
+    Tiny::vector<Tiny::map<int, int>> tables;
+    for (int i = 0; i < 10; i++) {
+        Tiny::map<int, int> t;
+        for (int j = 0; j <= i; j++)
+            t[j] = i;
+        tables.push_back(t);
+    }
+    auto first_root = tables[0].begin();
+    for (int i = 0; i < 100; i++)
+        tables.push_back(Tiny::map<int, int>());
+    std::cout << "nothrow move: " << std::is_nothrow_move_constructible<Tiny::map<int, int>>::value
+              << ", tables[9] size = " << tables[9].size()
+              << ", tables[0] node kept: " << (tables[0].begin() == first_root) << std::endl;
+    Tiny::map<int, int> moved(std::move(tables[9]));
+    tables[9] = std::move(moved);
+    moved[1] = 1;
+    std::cout << "moved back: " << tables[9].size() << ", reused: " << moved.size() << std::endl;
+}
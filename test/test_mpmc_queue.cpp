@@ -0,0 +1,52 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "tiny_mpmc_queue.h"
+
+using namespace Tiny;
+using std::cout;
+using std::endl;
+
+int main(void)
+{
+    mpmc_queue<int> q(100);
+    cout << "capacity = " << q.capacity() << endl;
+
+    int a[] = { 1, 2, 3, 4, 5 };
+    cout << "pushed = " << q.try_push_n(a, 5) << endl;
+    int x;
+    q.try_pop(x);
+    cout << "front = " << x << ", size = " << q.size() << endl;
+    int b[8];
+    size_t n = q.try_pop_n(b, 8);
+    cout << "popped = " << n << endl;
+    for (size_t i = 0; i < n; i++)
+        cout << b[i] << ' ';
+    cout << endl;
+    cout << "try_pop on empty = " << q.try_pop(x) << endl;
+
+    const int threads = 4;
+    const int count = 200000;
+    std::atomic<long long> sum(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&q] {
+            for (int i = 1; i <= count; i++)
+                q.push(i);
+        });
+        workers.emplace_back([&q, &sum] {
+            long long local = 0;
+            for (int i = 1; i <= count; i++) {
+                int y;
+                q.pop(y);
+                local += y;
+            }
+            sum += local;
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    cout << "sum = " << sum << endl;
+    cout << "empty = " << q.empty() << endl;
+}
@@ -25,4 +25,26 @@ int main(void)
     for (auto it = s.begin(); it != s.end(); it++)
         cout << *it << ' ';
     cout << endl;
-}
\ No newline at end of file
+
+    Tiny::multiset<int, std::less<int>, Tiny::alloc, Tiny::order_statistics> latency;
+    for (int i = 1; i <= 1000; i++)
+        latency.insert((i * 37) % 500);
+    cout << "p50 = " << *latency.select(latency.size() / 2)
+         << ", p99 = " << *latency.select(latency.size() * 99 / 100) << endl;
+    cout << "rank(250) = " << latency.rank(250) << endl;
+    cout << "count(7) = " << latency.count(7) << ", distance = "
+         << Tiny::distance(latency.lower_bound(100), latency.upper_bound(199)) << endl;
+    latency.erase(7);
+    cout << "size = " << latency.size() << ", rank(250) = " << latency.rank(250) << endl;
+
+    // a hot key: one descent finds the run, a long run is erased by splits
+    Tiny::multiset<int> hot;
+    for (int i = 0; i < 3000; i++)
+        hot.insert(i % 3 == 0 ? 42 : i);
+    auto range = hot.equal_range(42);
+    cout << "equal_range(42) = " << Tiny::distance(range.first, range.second)
+         << ", before " << *--range.first << ", after " << *range.second << endl;
+    cout << "count(42) = " << hot.count(42) << endl;
+    cout << "erase(42) = " << hot.erase(42) << ", size = " << hot.size()
+         << ", count(42) = " << hot.count(42) << endl;
+}
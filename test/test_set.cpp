@@ -1,5 +1,17 @@
 #include "tiny_set.h"
 #include <iostream>
+#include <stdexcept>
+
+// throws on the n-th comparison from now
+struct fussy_less
+{
+    static int left;
+    bool operator()(int a, int b) const {
+        if (left >= 0 and left-- == 0) throw std::runtime_error("compare");
+        return a < b;
+    }
+};
+int fussy_less::left = -1;
 
 int main(void)
 {
@@ -25,4 +37,53 @@ int main(void)
     for (auto it = s.begin(); it != s.end(); it++)
         cout << *it << ' ';
     cout << endl;
-}
\ No newline at end of file
+
+    int sorted[] = { 1, 2, 2, 3, 5, 8 };
+    Tiny::set<int> built(sorted, sorted + 6);
+    cout << "built size = " << built.size() << endl;
+    built.insert(a, a + 5);
+    for (auto it = built.begin(); it != built.end(); it++)
+        cout << *it << ' ';
+    cout << endl;
+
+    Tiny::set<int> evens, odds, high;
+    for (int i = 0; i < 20; i++)
+        (i % 2 ? odds : evens).insert(i);
+    evens.split(10, high);
+    cout << "split at 10: " << evens.size() << " below, " << high.size() << " from "
+         << *high.begin() << endl;
+    evens.join(high);
+    evens.set_union(odds);
+    cout << "union size = " << evens.size() << ", odds left = " << odds.size() << endl;
+    for (int i = 5; i < 25; i++)
+        odds.insert(i);
+    evens.set_intersection(odds);
+    cout << "intersection: " << *evens.begin() << ".." << *--evens.end()
+         << ", size = " << evens.size() << endl;
+    for (int i = 0; i < 10; i++)
+        odds.insert(i * 2);
+    evens.set_difference(odds);
+    for (auto it = evens.begin(); it != evens.end(); it++)
+        cout << *it << ' ';
+    cout << "(difference)" << endl;
+
+    // a throwing compare leaves both sets valid, losing nothing to a union
+    Tiny::set<int, fussy_less> p, q;
+    for (int i = 0; i < 1000; i++)
+        (i % 3 ? p : q).insert(i);
+    fussy_less::left = 100;
+    try {
+        p.set_union(q);
+    }
+    catch (const std::runtime_error&) {
+        cout << "union threw, sizes " << p.size() << " + " << q.size() << " = " << p.size() + q.size() << endl;
+    }
+    fussy_less::left = -1;
+
+    int probes[] = { 7, 8, 9, 100, 5 };
+    Tiny::set<int>::iterator hits[5];
+    evens.find_many(probes, probes + 5, hits);
+    for (int i = 0; i < 5; i++)
+        cout << probes[i] << (hits[i] == evens.end() ? " missing " : " found ");
+    cout << endl;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <stdexcept>
+#include "tiny_slist.h"
+
+using namespace Tiny;
+using std::cout;
+using std::endl;
+
+template <typename List>
+void print(const List& l)
+{
+    for (auto it = l.begin(); it != l.end(); ++it)
+        cout << *it << ' ';
+    cout << "(size = " << l.size() << ')' << endl;
+}
+
+int main(void)
+{
+    slist<int> s;
+    for (int i = 0; i < 6; i++)
+        s.push_front(i);
+    print(s);
+
+    auto it = s.begin();
+    ++it;
+    s.insert_after(it, 42);
+    s.erase_after(s.begin());
+    print(s);
+    cout << "front = " << s.front() << endl;
+    s.pop_front();
+    s.reverse();
+    print(s);
+
+    int arr[] = { 9, 3, 7, 3, 1 };
+    slist<int> other(arr, arr + 5);
+    other.remove(3);
+    print(other);
+
+    s.splice_after(s.before_begin(), other, other.begin());
+    print(s);
+    print(other);
+    s.splice_after(s.begin(), other);
+    print(s);
+    cout << "other empty = " << other.empty() << endl;
+
+    s.sort();
+    print(s);
+    slist<int> evens;
+    for (int i = 10; i >= 0; i -= 2)
+        evens.push_front(i);
+    s.merge(evens);
+    print(s);
+
+    auto first = s.begin();
+    auto last = first;
+    for (int i = 0; i < 4; i++) ++last;
+    other.splice_after(other.before_begin(), s, first, last);
+    print(s);
+    print(other);
+
+    slist<int> copy(s);
+    s.clear();
+    copy.sort([](int a, int b) { return a > b; });
+    print(copy);
+    slist<int> moved(std::move(copy));
+    cout << "moved.size = " << moved.size() << ", copy.size = " << copy.size() << endl;
+
+    // a throwing compare keeps every node, the ones merged in from x too
+    moved.reverse();
+    slist<int> odds;
+    for (int i = 1; i < 20; i += 2)
+        odds.push_front(i);
+    int left = 5;
+    try {
+        moved.merge(odds, [&left](int a, int b) {
+            if (left-- == 0) throw std::runtime_error("compare");
+            return a < b;
+        });
+    }
+    catch (const std::runtime_error&) {
+        size_t n = 0;
+        for (auto it = moved.begin(); it != moved.end(); ++it) n++;
+        cout << "merge threw, size = " << moved.size() << ", walked = " << n << ", other = " << odds.size() << endl;
+    }
+}
@@ -0,0 +1,38 @@
+#include <iostream>
+#include <thread>
+#include "tiny_spsc_queue.h"
+
+using namespace Tiny;
+using std::cout;
+using std::endl;
+
+int main(void)
+{
+    spsc_queue<int> q(1000);
+    cout << "capacity = " << q.capacity() << endl;
+
+    int a[] = { 1, 2, 3, 4, 5 };
+    cout << "pushed = " << q.push_n(a, 5) << endl;
+    int b[8];
+    size_t n = q.pop_n(b, 8);
+    cout << "popped = " << n << endl;
+    for (size_t i = 0; i < n; i++)
+        cout << b[i] << ' ';
+    cout << endl;
+
+    const int count = 1000000;
+    std::thread producer([&q] {
+        for (int i = 1; i <= count; i++)
+            q.push(i);
+    });
+
+    long long sum = 0;
+    for (int i = 1; i <= count; i++) {
+        int x;
+        q.pop(x);
+        sum += x;
+    }
+    producer.join();
+    cout << "sum = " << sum << endl;
+    cout << "empty = " << q.empty() << endl;
+}
@@ -52,4 +52,68 @@ int main(void)
     show(t);
     t.erase(0);
     show(t);
-}
\ No newline at end of file
+
+    std::cout << "verify = " << t.__rb_verify() << std::endl;
+
+    int sorted[100];
+    for (int n = 0; n <= 100; n++) {
+        for (int i = 0; i < n; i++)
+            sorted[i] = i / 2;
+        tree u, e;
+        u.insert_unique(sorted, sorted + n);
+        e.insert_equal(sorted, sorted + n);
+        if (!u.__rb_verify() or !e.__rb_verify() or
+            u.size() != size_t(n + 1) / 2 or e.size() != size_t(n)) {
+            std::cout << "sorted build failed at n = " << n << std::endl;
+            return 1;
+        }
+    }
+    int unsorted[] = { 3, 1, 2, 2 };
+    tree v;
+    v.insert_unique(unsorted, unsorted + 4);
+    std::cout << "verify = " << v.__rb_verify() << ", ";
+    show(v);
+    tree w;
+    w.insert_equal(sorted, sorted + 9);
+    std::cout << "verify = " << w.__rb_verify() << ", ";
+    show(w);
+    w.clear();
+    std::cout << "verify after clear = " << w.__rb_verify() << std::endl;
+
+    tree h;
+    for (int i = 0; i < 1000; i++)
+        h.insert_unique(h.end(), i);
+    h.insert_unique(h.begin(), -1);
+    h.insert_equal(h.find(500), 500);
+    h.insert_equal(h.find(500), 700);
+    h.insert_unique(h.find(10), 10);
+    std::cout << "hinted size = " << h.size() << ", verify = " << h.__rb_verify() << std::endl;
+
+    // the compact layout keeps the color in the parent pointer
+    using compact_tree = rb_tree<int, int, Comp, std::less<int>, alloc, compact_node>;
+    std::cout << "node size = " << sizeof(__rb_tree_node<int>)
+              << ", compact = " << sizeof(__rb_tree_node<int, compact_node>) << std::endl;
+    compact_tree c;
+    for (int i = 0; i < 1000; i++)
+        c.insert_equal(i * 7919 % 1000);
+    for (int i = 0; i < 1000; i += 3)
+        c.erase(i);
+    compact_tree d(c);
+    int prev = -1;
+    bool ordered = true;
+    for (auto it = d.begin(); it != d.end(); ++it)
+        ordered = ordered and *it > prev, prev = *it;
+    prev = 1000;
+    for (auto it = d.end(); it != d.begin(); prev = *it)
+        if (!(*--it < prev)) ordered = false;
+    std::cout << "compact size = " << d.size() << ", verify = " << c.__rb_verify() << d.__rb_verify()
+              << ", ordered = " << ordered << std::endl;
+
+    rb_tree<int, int, Comp, std::less<int>, alloc, compact_order_statistics> os;
+    for (int i = 0; i < 100; i++)
+        os.insert_unique(i * 37 % 100);
+    os.erase(50);
+    std::cout << "select(50) = " << *os.select(50) << ", rank(70) = " << os.rank(70)
+              << ", distance = " << distance(os.begin(), os.find(70))
+              << ", verify = " << os.__rb_verify() << std::endl;
+}
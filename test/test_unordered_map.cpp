@@ -31,4 +31,20 @@ int main(void)
 
     for (const auto& [s, n] : h)
         cout << s << ' ' << n << endl;
-}
\ No newline at end of file
+
+    Tiny::unordered_map<string, int> spare;
+    spare["june"] = 0;
+    auto node = h.extract("september");
+    node.value().second = 30;
+    spare.insert(std::move(node));
+    spare.merge(h);
+    cout << "h: " << h.size() << " (june -> " << h["june"] << "), spare: " << spare.size()
+         << " (september -> " << spare["september"] << ")" << endl;
+
+    Tiny::unordered_map<string, int, Tiny::hash<string>, std::equal_to<>> days;
+    for (const auto& [s, n] : spare)
+        days[s] = n;
+    string_view sv = "february";
+    cout << "string_view -> " << days.find(sv)->second
+         << ", const char* count = " << days.count("may") << endl;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <string>
+#include "tiny_unrolled_list.h"
+
+using namespace Tiny;
+using std::cout;
+using std::endl;
+
+template <typename List>
+void print(const List& l)
+{
+    for (auto it = l.begin(); it != l.end(); ++it)
+        cout << *it << ' ';
+    cout << "(size = " << l.size() << ')' << endl;
+}
+
+int main(void)
+{
+    cout << "block_size<int> = " << unrolled_list<int>::block_size << endl;
+
+    unrolled_list<int, 4> l;
+    for (int i = 0; i < 10; i++)
+        l.push_back(i);
+    l.push_front(-1);
+    print(l);
+
+    auto it = l.begin();
+    for (int i = 0; i < 3; i++) ++it;
+    it = l.insert(it, 100);
+    cout << "inserted " << *it << endl;
+    print(l);
+
+    it = l.erase(it);
+    cout << "after erase " << *it << endl;
+    l.pop_front();
+    l.pop_back();
+    print(l);
+    cout << "front = " << l.front() << ", back = " << l.back() << endl;
+
+    for (auto i = l.begin(); i != l.end(); )
+        i = (*i % 2 == 0) ? l.erase(i) : ++i;
+    print(l);
+
+    unrolled_list<int, 4> other;
+    for (int i = 10; i < 16; i++)
+        other.push_back(i);
+    it = l.begin();
+    ++it;
+    l.splice(it, other);
+    print(l);
+    cout << "other empty = " << other.empty() << endl;
+
+    auto first = l.begin();
+    ++first;
+    auto last = first;
+    advance(last, 5);
+    other.splice(other.end(), l, first, last);
+    print(l);
+    print(other);
+
+    auto r = l.end();
+    cout << "reverse: ";
+    while (r != l.begin())
+        cout << *--r << ' ';
+    cout << endl;
+
+    cout << "distance = " << distance(l.begin(), l.end()) << endl;
+
+    unrolled_list<std::string> s;
+    for (int i = 0; i < 20; i++)
+        s.push_back(std::to_string(i));
+    unrolled_list<std::string> copy(s);
+    s.clear();
+    copy.erase(copy.begin());
+    print(copy);
+    s = copy;
+    unrolled_list<std::string> moved(std::move(copy));
+    cout << "s.size = " << s.size() << ", moved.size = " << moved.size()
+         << ", copy.size = " << copy.size() << endl;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "tiny_ws_deque.h"
+
+using namespace Tiny;
+using std::cout;
+using std::endl;
+
+int main(void)
+{
+    ws_deque<int> d(4);
+    for (int i = 1; i <= 10; i++)
+        d.push(i);
+    cout << "size = " << d.size() << ", capacity = " << d.capacity() << endl;
+
+    int x;
+    d.pop(x);
+    cout << "pop = " << x << endl;
+    d.steal(x);
+    cout << "steal = " << x << endl;
+    while (d.pop(x))
+        cout << x << ' ';
+    cout << endl;
+    cout << "empty = " << d.empty() << endl;
+
+    const int count = 1000000;
+    const int thieves = 3;
+    std::atomic<long long> sum(0);
+    std::atomic<int> taken(0);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < thieves; t++) {
+        workers.emplace_back([&] {
+            long long local = 0;
+            int y;
+            while (!done.load()) {
+                if (d.steal(y)) {
+                    local += y;
+                    taken++;
+                }
+            }
+            sum += local;
+        });
+    }
+
+    long long local = 0;
+    for (int i = 1; i <= count; i++) {
+        d.push(i);
+        if (i % 3 == 0 and d.pop(x)) {
+            local += x;
+            taken++;
+        }
+    }
+    while (d.pop(x)) {
+        local += x;
+        taken++;
+    }
+    while (taken.load() != count)
+        std::this_thread::yield();
+    done = true;
+    for (auto& w : workers)
+        w.join();
+    sum += local;
+    cout << "taken = " << taken << endl;
+    cout << "sum = " << sum << endl;
+}
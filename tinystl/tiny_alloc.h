@@ -30,6 +30,18 @@ public:
         free(p);
     }
 
+    // nobjs separate objects of n bytes, linked through their first word
+    static void* allocate_chain(size_t n, int nobjs)
+    {
+        void* result = nullptr;
+        for (int i = 0; i < nobjs; i++) {
+            void* p = allocate(n);
+            *static_cast<void**>(p) = result;
+            result = p;
+        }
+        return result;
+    }
+
     static void* reallocate(void* p, size_t, size_t new_sz)
     {
         void *result = realloc(p, new_sz);
@@ -109,6 +121,7 @@ private:
 
 public:
     static void* allocate(size_t n);
+    static void* allocate_chain(size_t n, int nobjs);
     static void* reallocate(void* p, size_t old_sz, size_t new_sz);
     static void deallocate(void* p, size_t n);
 };
@@ -141,6 +154,41 @@ void* __default_alloc_template<threads, inst>::allocate(size_t n)
     return result;
 }
 
+// up to nobjs objects linked through free_list_link and terminated by nullptr:
+// whatever the free list holds first, the rest carved from one chunk. Each
+// object is later returned with a plain deallocate()
+template <bool threads, int inst>
+void* __default_alloc_template<threads, inst>::allocate_chain(size_t n, int nobjs)
+{
+    if (n > __MAX_BYTES)
+        return malloc_alloc::allocate_chain(n, nobjs);
+
+    obj* volatile * my_free_list = free_list + FREELIST_INDEX(n);
+    obj* result = *my_free_list;
+    obj* tail = nullptr;
+    obj* cur = result;
+    for (; cur != nullptr and nobjs > 0; nobjs--) {
+        tail = cur;
+        cur = cur -> free_list_link;
+    }
+    *my_free_list = cur;
+    if (nobjs == 0) {
+        tail -> free_list_link = nullptr;
+        return result;
+    }
+
+    n = ROUND_UP(n);
+    char* chunk = chunk_alloc(n, nobjs);
+    obj* first = (obj*)chunk;
+    for (int i = 0; i < nobjs - 1; i++)
+        ((obj*)(chunk + i * n)) -> free_list_link = (obj*)(chunk + (i + 1) * n);
+    ((obj*)(chunk + (nobjs - 1) * n)) -> free_list_link = nullptr;
+    if (tail == nullptr)
+        return first;
+    tail -> free_list_link = first;
+    return result;
+}
+
 template <bool threads, int inst>
 void __default_alloc_template<threads, inst>::deallocate(void* p, size_t n)
 {
@@ -190,7 +238,7 @@ char* __default_alloc_template<threads, inst>::chunk_alloc(size_t size, int& nob
         return result;
     }
     if (bytes_left >= size) {
-        nobjs = bytes_left >= size;
+        nobjs = bytes_left / size;
         total_bytes = size * nobjs;
         char* result = start_free;
         start_free += total_bytes;
@@ -215,9 +263,8 @@ char* __default_alloc_template<threads, inst>::chunk_alloc(size_t size, int& nob
                 return chunk_alloc(size, nobjs);
             }
         }
+        start_free = (char*)malloc_alloc::allocate(bytes_to_get);
     }
-
-    start_free = (char*)malloc_alloc::allocate(bytes_to_get);
     end_free = start_free + bytes_to_get;
     heap_size += bytes_to_get;
     return chunk_alloc(size, nobjs);
@@ -250,6 +297,16 @@ public:
     {
         Alloc::deallocate(p, sizeof(T));
     }
+    // up to n uninitialized objects linked through their first word; T must
+    // be at least pointer-sized
+    static T* allocate_chain(int n)
+    {
+        return static_cast<T*>(Alloc::allocate_chain(sizeof(T), n));
+    }
+    static T* chain_next(T* p)
+    {
+        return *reinterpret_cast<T**>(p);
+    }
 };
 
 #ifdef __USE_MALLOC
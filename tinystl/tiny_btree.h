@@ -0,0 +1,800 @@
+#pragma once
+
+#include <iso646.h>
+#include <type_traits>
+#include <utility>
+#include "tiny_construct.h"
+#include "tiny_alloc.h"
+#include "tiny_iterator.h"
+
+namespace Tiny
+{
+
+// a node is sized to about four cache lines; values live in every node, and
+// internal nodes carry count + 1 children after the leaf part
+const size_t __btree_node_bytes = 256;
+
+constexpr size_t __btree_node_values(size_t sz) {
+    return (__btree_node_bytes - 16) / sz < 3 ? 3 :
+           (__btree_node_bytes - 16) / sz > 255 ? 255 : (__btree_node_bytes - 16) / sz;
+}
+
+template <typename Value, size_t N>
+struct __btree_internal_node;
+
+template <typename Value, size_t N>
+struct __btree_node
+{
+    using node_pointer = __btree_node<Value, N>*;
+    node_pointer parent;
+    unsigned short position;  // index among the parent's children
+    unsigned short count;
+    bool leaf;
+    alignas(Value) unsigned char storage[N * sizeof(Value)];
+
+    Value& value(size_t i) { return reinterpret_cast<Value*>(storage)[i]; }
+    node_pointer& child(size_t i) {
+        return static_cast<__btree_internal_node<Value, N>*>(this)->children[i];
+    }
+};
+
+template <typename Value, size_t N>
+struct __btree_internal_node : public __btree_node<Value, N>
+{
+    __btree_node<Value, N>* children[N + 1];
+};
+
+template <typename Value, typename Ref, typename Ptr, size_t N>
+struct __btree_iterator
+{
+    using iterator = __btree_iterator<Value, Value&, Value*, N>;
+    using const_iterator = __btree_iterator<Value, const Value&, const Value*, N>;
+    using self = __btree_iterator<Value, Ref, Ptr, N>;
+
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = Value;
+    using pointer = Ptr;
+    using reference = Ref;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using node_pointer = __btree_node<Value, N>*;
+
+    node_pointer node;
+    size_type position;
+
+    __btree_iterator() { }
+    __btree_iterator(node_pointer x, size_type i) : node(x), position(i) { }
+    __btree_iterator(const iterator& x) : node(x.node), position(x.position) { }
+    self& operator=(const self&) = default;
+
+    bool operator==(const self& x) const { return node == x.node and position == x.position; }
+    bool operator!=(const self& x) const { return !(*this == x); }
+    reference operator*() const { return node->value(position); }
+    pointer operator->() const { return &operator*(); }
+
+    // past the last value of a leaf, climb to the first ancestor that still
+    // has a separator to the right; past the root that is end()
+    void increment()
+    {
+        if (!node->leaf) {
+            node = node->child(position + 1);
+            while (!node->leaf)
+                node = node->child(0);
+            position = 0;
+            return;
+        }
+        if (++position < node->count)
+            return;
+        self save = *this;
+        while (position == node->count) {
+            if (node->parent == nullptr) {
+                *this = save;
+                return;
+            }
+            position = node->position;
+            node = node->parent;
+        }
+    }
+    void decrement()
+    {
+        if (!node->leaf) {
+            node = node->child(position);
+            while (!node->leaf)
+                node = node->child(node->count);
+            position = node->count - 1;
+            return;
+        }
+        if (position > 0) {
+            position--;
+            return;
+        }
+        self save = *this;
+        while (position == 0) {
+            if (node->parent == nullptr) {
+                *this = save;
+                return;
+            }
+            position = node->position;
+            node = node->parent;
+        }
+        position--;
+    }
+
+    self& operator++() {
+        increment();
+        return *this;
+    }
+    self operator++(int) {
+        self tmp = *this;
+        increment();
+        return tmp;
+    }
+    self& operator--() {
+        decrement();
+        return *this;
+    }
+    self operator--(int) {
+        self tmp = *this;
+        decrement();
+        return tmp;
+    }
+};
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc = alloc>
+class btree
+{
+public:
+    static const size_t node_values = __btree_node_values(sizeof(Value));
+
+protected:
+    using btree_node = __btree_node<Value, node_values>;
+    using internal_node = __btree_internal_node<Value, node_values>;
+    using leaf_allocator = simple_alloc<btree_node, Alloc>;
+    using internal_allocator = simple_alloc<internal_node, Alloc>;
+    using node_pointer = btree_node*;
+
+    // small keys are searched by counting the smaller ones in a plain loop the
+    // compiler can vectorize; everything else by binary search
+    static const bool linear_search = std::is_arithmetic<Key>::value or std::is_pointer<Key>::value;
+    static const size_t min_values = (node_values - 1) / 2;
+
+public:
+    using key_type = Key;
+    using value_type = Value;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = __btree_iterator<Value, Value&, Value*, node_values>;
+    using const_iterator = __btree_iterator<Value, const Value&, const Value*, node_values>;
+    using self = btree<Key, Value, KeyOfValue, Compare, Alloc>;
+
+protected:
+    node_pointer root;
+    node_pointer leftmost;
+    node_pointer rightmost;
+    size_type node_count;
+    Compare key_compare;
+
+    static const Key& key(node_pointer x, size_type i) { return KeyOfValue()(x->value(i)); }
+
+    node_pointer new_node(bool leaf, node_pointer parent, size_type position) {
+        node_pointer x = leaf ? leaf_allocator::allocate() : internal_allocator::allocate();
+        x->parent = parent;
+        x->position = (unsigned short)position;
+        x->count = 0;
+        x->leaf = leaf;
+        if (!leaf)
+            for (size_type i = 0; i <= node_values; i++)
+                x->child(i) = nullptr;
+        return x;
+    }
+    void delete_node(node_pointer x) {
+        for (size_type i = 0; i < x->count; i++)
+            destroy(&x->value(i));
+        if (x->leaf)
+            leaf_allocator::deallocate(x);
+        else
+            internal_allocator::deallocate(static_cast<internal_node*>(x));
+    }
+    // moves the value in (from, j) into the raw slot (to, i)
+    static void move_value(node_pointer to, size_type i, node_pointer from, size_type j) {
+        construct(&to->value(i), std::move(from->value(j)));
+        destroy(&from->value(j));
+    }
+    static void set_child(node_pointer x, size_type i, node_pointer c) {
+        x->child(i) = c;
+        c->parent = x;
+        c->position = (unsigned short)i;
+    }
+
+    size_type lower_bound_in(node_pointer x, const Key& k) const;
+    size_type upper_bound_in(node_pointer x, const Key& k) const;
+    void update_extremes();
+    void split(node_pointer x, size_type mid);
+    iterator insert_leaf(node_pointer x, size_type i, const value_type& v);
+    iterator insert_before(iterator position, const value_type& v);
+    void merge(node_pointer parent, size_type i);
+    void rebalance(node_pointer x);
+    void erase_value(node_pointer x, size_type i);
+    node_pointer copy_subtree(node_pointer x, node_pointer parent);
+    void erase_subtree(node_pointer x);
+    bool verify_subtree(node_pointer x, int depth, int& leaf_depth, size_type& n) const;
+
+public:
+    btree(const Compare& comp = Compare())
+        : root(nullptr), leftmost(nullptr), rightmost(nullptr), node_count(0), key_compare(comp) { }
+    btree(const self&);
+    btree(self&&) noexcept;
+    ~btree() { clear(); }
+    self& operator=(const self&);
+    self& operator=(self&&) noexcept;
+    void swap(self&) noexcept;
+
+    Compare key_comp() const { return key_compare; }
+    iterator begin() { return iterator(leftmost, 0); }
+    iterator end() { return iterator(rightmost, rightmost ? rightmost->count : 0); }
+    const_iterator begin() const { return const_iterator(leftmost, 0); }
+    const_iterator end() const { return const_iterator(rightmost, rightmost ? rightmost->count : 0); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    static size_type max_size() { return size_type(-1); }
+
+    iterator find(const Key&);
+    const_iterator find(const Key& k) const { return const_cast<self*>(this)->find(k); }
+    iterator lower_bound(const Key&);
+    iterator upper_bound(const Key&);
+    const_iterator lower_bound(const Key& k) const { return const_cast<self*>(this)->lower_bound(k); }
+    const_iterator upper_bound(const Key& k) const { return const_cast<self*>(this)->upper_bound(k); }
+    std::pair<iterator, iterator> equal_range(const Key& k) {
+        return std::pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const Key& k) const {
+        return std::pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+    size_type count(const Key&) const;
+
+    std::pair<iterator, bool> insert_unique(const value_type&);
+    iterator insert_equal(const value_type&);
+    iterator insert_unique(iterator position, const value_type&);
+    iterator insert_equal(iterator position, const value_type&);
+    // sorted input goes through the end() hint and packs the nodes
+    template <typename InputIterator>
+    void insert_unique(InputIterator first, InputIterator last) {
+        for (; first != last; ++first)
+            insert_unique(end(), *first);
+    }
+    template <typename InputIterator>
+    void insert_equal(InputIterator first, InputIterator last) {
+        for (; first != last; ++first)
+            insert_equal(end(), *first);
+    }
+    // any insert or erase moves values between nodes, so it invalidates every
+    // iterator, end() included; erase hands back the successor instead
+    iterator erase(iterator);
+    size_type erase(const Key&);
+    void clear();
+
+    bool __btree_verify() const;
+};
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+const size_t btree<Key, Value, KeyOfValue, Compare, Alloc>::node_values;
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::lower_bound_in(node_pointer x, const Key& k) const -> size_type
+{
+    if (linear_search) {
+        size_type r = 0;
+        for (size_type i = 0; i < x->count; i++)
+            r += key_compare(key(x, i), k);
+        return r;
+    }
+    size_type first = 0, len = x->count;
+    while (len > 0) {
+        size_type half = len / 2;
+        if (key_compare(key(x, first + half), k))
+            first += half + 1, len -= half + 1;
+        else
+            len = half;
+    }
+    return first;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::upper_bound_in(node_pointer x, const Key& k) const -> size_type
+{
+    if (linear_search) {
+        size_type r = 0;
+        for (size_type i = 0; i < x->count; i++)
+            r += !key_compare(k, key(x, i));
+        return r;
+    }
+    size_type first = 0, len = x->count;
+    while (len > 0) {
+        size_type half = len / 2;
+        if (!key_compare(k, key(x, first + half)))
+            first += half + 1, len -= half + 1;
+        else
+            len = half;
+    }
+    return first;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::update_extremes()
+{
+    if (root == nullptr) {
+        leftmost = rightmost = nullptr;
+        return;
+    }
+    for (leftmost = root; !leftmost->leaf; leftmost = leftmost->child(0)) { }
+    for (rightmost = root; !rightmost->leaf; rightmost = rightmost->child(rightmost->count)) { }
+}
+
+// x is full: values [0, mid) stay, mid moves up to the parent and the rest go
+// to a new right sibling. A full parent is split first
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::split(node_pointer x, size_type mid)
+{
+    if (x->parent == nullptr) {
+        root = new_node(false, nullptr, 0);
+        set_child(root, 0, x);
+    }
+    else if (x->parent->count == node_values) {
+        split(x->parent, node_values / 2);
+    }
+
+    node_pointer parent = x->parent;
+    size_type pos = x->position;
+    node_pointer sibling = new_node(x->leaf, parent, pos + 1);
+    for (size_type i = mid + 1; i < x->count; i++)
+        move_value(sibling, i - mid - 1, x, i);
+    if (!x->leaf)
+        for (size_type i = mid + 1; i <= x->count; i++)
+            set_child(sibling, i - mid - 1, x->child(i));
+    sibling->count = (unsigned short)(x->count - mid - 1);
+
+    for (size_type i = parent->count; i > pos; i--) {
+        move_value(parent, i, parent, i - 1);
+        set_child(parent, i + 1, parent->child(i));
+    }
+    move_value(parent, pos, x, mid);
+    set_child(parent, pos + 1, sibling);
+    parent->count++;
+    x->count = (unsigned short)mid;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_leaf(node_pointer x, size_type i, const value_type& v) -> iterator
+{
+    if (root == nullptr) {
+        root = x = new_node(true, nullptr, 0);
+        i = 0;
+    }
+    else if (x->count == node_values) {
+        // appending at the very end leaves the old node nearly full, so
+        // ascending inserts pack the nodes instead of leaving them half empty
+        size_type mid = i == node_values ? node_values - 2 : node_values / 2;
+        split(x, mid);
+        if (i > mid) {
+            x = x->parent->child(x->position + 1);
+            i -= mid + 1;
+        }
+    }
+    for (size_type j = x->count; j > i; j--)
+        move_value(x, j, x, j - 1);
+    try {
+        construct(&x->value(i), v);
+    }
+    catch (...) {
+        for (size_type j = i; j < x->count; j++)
+            move_value(x, j, x, j + 1);
+        throw;
+    }
+    x->count++;
+    node_count++;
+    update_extremes();
+    return iterator(x, i);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const value_type& v) -> std::pair<iterator, bool>
+{
+    node_pointer x = root;
+    size_type i = 0;
+    const Key& k = KeyOfValue()(v);
+    while (x != nullptr) {
+        i = lower_bound_in(x, k);
+        if (i < x->count and !key_compare(k, key(x, i)))
+            return std::pair<iterator, bool>(iterator(x, i), false);
+        if (x->leaf) break;
+        x = x->child(i);
+    }
+    return std::pair<iterator, bool>(insert_leaf(x, i, v), true);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const value_type& v) -> iterator
+{
+    node_pointer x = root;
+    size_type i = 0;
+    while (x != nullptr) {
+        i = upper_bound_in(x, KeyOfValue()(v));
+        if (x->leaf) break;
+        x = x->child(i);
+    }
+    return insert_leaf(x, i, v);
+}
+
+// the slot just before position is either position itself, when it is in a
+// leaf, or the one after its predecessor, which always ends a leaf
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_before(iterator position, const value_type& v) -> iterator
+{
+    if (root == nullptr or position.node->leaf)
+        return insert_leaf(position.node, position.position, v);
+    --position;
+    return insert_leaf(position.node, position.position + 1, v);
+}
+
+// O(1) amortized when v belongs right before position, as with sorted input
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(iterator position, const value_type& v) -> iterator
+{
+    const Key& k = KeyOfValue()(v);
+    if (position == end()) {
+        if (empty() or key_compare(KeyOfValue()(*--end()), k))
+            return insert_before(position, v);
+    }
+    else if (key_compare(k, KeyOfValue()(*position))) {
+        if (position == begin())
+            return insert_before(position, v);
+        iterator before = position;
+        if (key_compare(KeyOfValue()(*--before), k))
+            return insert_before(position, v);
+    }
+    return insert_unique(v).first;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(iterator position, const value_type& v) -> iterator
+{
+    const Key& k = KeyOfValue()(v);
+    if (position == end()) {
+        if (empty() or !key_compare(k, KeyOfValue()(*--end())))
+            return insert_before(position, v);
+    }
+    else if (!key_compare(KeyOfValue()(*position), k)) {
+        if (position == begin())
+            return insert_before(position, v);
+        iterator before = position;
+        if (!key_compare(k, KeyOfValue()(*--before)))
+            return insert_before(position, v);
+    }
+    return insert_equal(v);
+}
+
+// the deepest candidate on the way down is the answer
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::lower_bound(const Key& k) -> iterator
+{
+    iterator result = end();
+    for (node_pointer x = root; x != nullptr; ) {
+        size_type i = lower_bound_in(x, k);
+        if (i < x->count)
+            result = iterator(x, i);
+        if (x->leaf) break;
+        x = x->child(i);
+    }
+    return result;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::upper_bound(const Key& k) -> iterator
+{
+    iterator result = end();
+    for (node_pointer x = root; x != nullptr; ) {
+        size_type i = upper_bound_in(x, k);
+        if (i < x->count)
+            result = iterator(x, i);
+        if (x->leaf) break;
+        x = x->child(i);
+    }
+    return result;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::find(const Key& k) -> iterator
+{
+    for (node_pointer x = root; x != nullptr; ) {
+        size_type i = lower_bound_in(x, k);
+        if (i < x->count and !key_compare(k, key(x, i)))
+            return iterator(x, i);
+        if (x->leaf) break;
+        x = x->child(i);
+    }
+    return end();
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::count(const Key& k) const -> size_type
+{
+    size_type n = 0;
+    for (const_iterator first = lower_bound(k), last = upper_bound(k); first != last; ++first)
+        n++;
+    return n;
+}
+
+// the separator i of parent and its right child are folded into child i
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::merge(node_pointer parent, size_type i)
+{
+    node_pointer left = parent->child(i);
+    node_pointer right = parent->child(i + 1);
+    size_type n = left->count;
+
+    move_value(left, n, parent, i);
+    for (size_type j = 0; j < right->count; j++)
+        move_value(left, n + 1 + j, right, j);
+    if (!left->leaf)
+        for (size_type j = 0; j <= right->count; j++)
+            set_child(left, n + 1 + j, right->child(j));
+    left->count = (unsigned short)(n + 1 + right->count);
+    right->count = 0;
+    delete_node(right);
+
+    for (size_type j = i + 1; j < parent->count; j++) {
+        move_value(parent, j - 1, parent, j);
+        set_child(parent, j, parent->child(j + 1));
+    }
+    parent->count--;
+}
+
+// refills an underfull x from a sibling, or merges it with one and goes on
+// with the parent
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::rebalance(node_pointer x)
+{
+    while (x != root and x->count < min_values)
+    {
+        node_pointer parent = x->parent;
+        size_type pos = x->position;
+        node_pointer left = pos > 0 ? parent->child(pos - 1) : nullptr;
+        node_pointer right = pos < parent->count ? parent->child(pos + 1) : nullptr;
+
+        if (left != nullptr and left->count > min_values) {
+            for (size_type j = x->count; j > 0; j--)
+                move_value(x, j, x, j - 1);
+            if (!x->leaf)
+                for (size_type j = x->count + 1; j > 0; j--)
+                    set_child(x, j, x->child(j - 1));
+            move_value(x, 0, parent, pos - 1);
+            move_value(parent, pos - 1, left, left->count - 1);
+            if (!x->leaf)
+                set_child(x, 0, left->child(left->count));
+            left->count--;
+            x->count++;
+            return;
+        }
+        if (right != nullptr and right->count > min_values) {
+            move_value(x, x->count, parent, pos);
+            move_value(parent, pos, right, 0);
+            if (!x->leaf)
+                set_child(x, x->count + 1, right->child(0));
+            for (size_type j = 1; j < right->count; j++)
+                move_value(right, j - 1, right, j);
+            if (!right->leaf)
+                for (size_type j = 1; j <= right->count; j++)
+                    set_child(right, j - 1, right->child(j));
+            right->count--;
+            x->count++;
+            return;
+        }
+        merge(parent, left != nullptr ? pos - 1 : pos);
+        x = parent;
+    }
+
+    if (root->count == 0) {
+        node_pointer old = root;
+        if (root->leaf) {
+            root = nullptr;
+        }
+        else {
+            root = root->child(0);
+            root->parent = nullptr;
+            root->position = 0;
+        }
+        delete_node(old);
+    }
+}
+
+// a value in an internal node is replaced by its predecessor, which always
+// sits at the end of a leaf, so values are only ever removed from leaves
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::erase_value(node_pointer x, size_type i)
+{
+    destroy(&x->value(i));
+    if (!x->leaf) {
+        node_pointer leaf = x->child(i);
+        while (!leaf->leaf)
+            leaf = leaf->child(leaf->count);
+        move_value(x, i, leaf, leaf->count - 1);
+        x = leaf;
+        i = leaf->count - 1;
+    }
+    else {
+        for (size_type j = i + 1; j < x->count; j++)
+            move_value(x, j - 1, x, j);
+    }
+    x->count--;
+    node_count--;
+    rebalance(x);
+    update_extremes();
+}
+
+// the successor may move while the tree rebalances, so it is found again by
+// its key and the number of equal keys in front of it
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::erase(iterator position) -> iterator
+{
+    iterator next = position;
+    ++next;
+    if (next == end()) {
+        erase_value(position.node, position.position);
+        return end();
+    }
+    Key k = key(next.node, next.position);
+    size_type skip = 0;
+    for (iterator it = lower_bound(k); it != next; ++it)
+        skip++;
+    if (!key_compare(key(position.node, position.position), k))
+        skip--;
+    erase_value(position.node, position.position);
+    for (next = lower_bound(k); skip > 0; skip--)
+        ++next;
+    return next;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::erase(const Key& k) -> size_type
+{
+    size_type n = 0;
+    for (iterator it = find(k); it != end(); it = find(k)) {
+        erase_value(it.node, it.position);
+        n++;
+    }
+    return n;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::erase_subtree(node_pointer x)
+{
+    if (!x->leaf)
+        for (size_type i = 0; i <= x->count; i++)
+            erase_subtree(x->child(i));
+    delete_node(x);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::clear()
+{
+    if (root != nullptr)
+        erase_subtree(root);
+    root = leftmost = rightmost = nullptr;
+    node_count = 0;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::copy_subtree(node_pointer x, node_pointer parent) -> node_pointer
+{
+    node_pointer top = new_node(x->leaf, parent, x->position);
+    try {
+        for (; top->count < x->count; top->count++)
+            construct(&top->value(top->count), x->value(top->count));
+        if (!x->leaf)
+            for (size_type i = 0; i <= x->count; i++)
+                top->child(i) = copy_subtree(x->child(i), top);
+    }
+    catch (...) {
+        // children copied so far are the non-null prefix of top's children
+        if (!top->leaf)
+            for (size_type i = 0; i <= x->count and top->child(i) != nullptr; i++)
+                erase_subtree(top->child(i));
+        delete_node(top);
+        throw;
+    }
+    return top;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+btree<Key, Value, KeyOfValue, Compare, Alloc>::btree(const self& x)
+    : root(nullptr), leftmost(nullptr), rightmost(nullptr), node_count(0), key_compare(x.key_compare)
+{
+    if (x.root == nullptr) return;
+    root = copy_subtree(x.root, nullptr);
+    node_count = x.node_count;
+    update_extremes();
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+btree<Key, Value, KeyOfValue, Compare, Alloc>::btree(self&& x) noexcept
+    : root(x.root), leftmost(x.leftmost), rightmost(x.rightmost),
+      node_count(x.node_count), key_compare(x.key_compare)
+{
+    x.root = x.leftmost = x.rightmost = nullptr;
+    x.node_count = 0;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::operator=(const self& x) -> self&
+{
+    if (this == &x) return *this;
+    self tmp(x);
+    swap(tmp);
+    return *this;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+auto btree<Key, Value, KeyOfValue, Compare, Alloc>::operator=(self&& x) noexcept -> self&
+{
+    if (this == &x) return *this;
+    self tmp(std::move(x));
+    swap(tmp);
+    return *this;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+void btree<Key, Value, KeyOfValue, Compare, Alloc>::swap(self& x) noexcept
+{
+    std::swap(root, x.root);
+    std::swap(leftmost, x.leftmost);
+    std::swap(rightmost, x.rightmost);
+    std::swap(node_count, x.node_count);
+    std::swap(key_compare, x.key_compare);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+bool btree<Key, Value, KeyOfValue, Compare, Alloc>::verify_subtree(node_pointer x, int depth, int& leaf_depth, size_type& n) const
+{
+    if (x->count == 0 or x->count > node_values) return false;
+    for (size_type i = 1; i < x->count; i++)
+        if (key_compare(key(x, i), key(x, i - 1))) return false;
+    n += x->count;
+    if (x->leaf) {
+        if (leaf_depth == -1) leaf_depth = depth;
+        return depth == leaf_depth;
+    }
+    for (size_type i = 0; i <= x->count; i++) {
+        node_pointer c = x->child(i);
+        if (c->parent != x or c->position != i) return false;
+        if (i > 0 and key_compare(key(c, 0), key(x, i - 1))) return false;
+        if (i < x->count and key_compare(key(x, i), key(c, c->count - 1))) return false;
+        if (!verify_subtree(c, depth + 1, leaf_depth, n)) return false;
+    }
+    return true;
+}
+
+// checks order, node links, equal leaf depth and the size; for tests
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
+bool btree<Key, Value, KeyOfValue, Compare, Alloc>::__btree_verify() const
+{
+    if (root == nullptr)
+        return node_count == 0 and leftmost == nullptr and rightmost == nullptr;
+    if (root->parent != nullptr)
+        return false;
+
+    size_type n = 0;
+    int leaf_depth = -1;
+    if (!verify_subtree(root, 0, leaf_depth, n) or n != node_count)
+        return false;
+
+    node_pointer l = root, r = root;
+    while (!l->leaf) l = l->child(0);
+    while (!r->leaf) r = r->child(r->count);
+    return l == leftmost and r == rightmost;
+}
+
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "tiny_btree.h"
+#include <functional>
+
+namespace Tiny
+{
+
+// map and multimap with the interface of map, kept in a btree; unlike map,
+// any insert or erase invalidates every iterator, end() included
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+class btree_map
+{
+public:
+    using key_type = Key;
+    using data_type = T;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using key_compare = Compare;
+    using self = btree_map<Key, T, Compare, Alloc>;
+
+    class value_compare
+    {
+        friend class btree_map<Key, T, Compare, Alloc>;
+    protected:
+        Compare comp;
+        value_compare(Compare c) : comp(c) { }
+    public:
+        bool operator()(const value_type& x, const value_type& y) const {
+            return comp(x.first, y.first);
+        }
+    };
+
+private:
+    using rep_type = btree<key_type, value_type, std::_Select1st<value_type>, key_compare, Alloc>;
+    rep_type t;
+
+public:
+    using pointer = typename rep_type::pointer;
+    using const_pointer = typename rep_type::const_pointer;
+    using reference = typename rep_type::reference;
+    using const_reference = typename rep_type::const_reference;
+    using iterator = typename rep_type::iterator;
+    using const_iterator = typename rep_type::const_iterator;
+    using size_type = typename rep_type::size_type;
+    using difference_type = typename rep_type::difference_type;
+
+    btree_map() : t(Compare()) { }
+    explicit btree_map(const Compare& comp) : t(comp) { }
+    template <typename InputIterator>
+    btree_map(InputIterator first, InputIterator last) : t(Compare()) { t.insert_unique(first, last); }
+    template <typename InputIterator>
+    btree_map(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_unique(first, last); }
+    btree_map(const self& x) : t(x.t) { }
+    btree_map(self&& x) noexcept : t(std::move(x.t)) { }
+    self& operator=(const self& x) { t = x.t; return *this; }
+    self& operator=(self&& x) noexcept { t = std::move(x.t); return *this; }
+
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    static size_type max_size() { return rep_type::max_size(); }
+    void swap(self& x) noexcept { t.swap(x.t); }
+
+    T& operator[](const key_type& k) {
+        iterator i = lower_bound(k);
+        if (i == end() or key_comp()(k, i->first))
+            i = insert(i, value_type(k, T()));
+        return i->second;
+    }
+
+    using pair_iterator_bool = std::pair<iterator, bool>;
+    pair_iterator_bool insert(const value_type& x) {
+        return t.insert_unique(x);
+    }
+    iterator insert(iterator position, const value_type& x) {
+        return t.insert_unique(position, x);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_unique(first, last);
+    }
+    iterator erase(iterator position) {
+        return t.erase(position);
+    }
+    size_type erase(const key_type& x) {
+        return t.erase(x);
+    }
+    void clear() { t.clear(); }
+
+    iterator find(const key_type& x) { return t.find(x); }
+    const_iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) { return t.lower_bound(x); }
+    const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
+    const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    std::pair<iterator, iterator> equal_range(const key_type& x) {
+        return t.equal_range(x);
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& x) const {
+        return t.equal_range(x);
+    }
+};
+
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+class btree_multimap
+{
+public:
+    using key_type = Key;
+    using data_type = T;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using key_compare = Compare;
+    using self = btree_multimap<Key, T, Compare, Alloc>;
+
+    class value_compare
+    {
+        friend class btree_multimap<Key, T, Compare, Alloc>;
+    protected:
+        Compare comp;
+        value_compare(Compare c) : comp(c) { }
+    public:
+        bool operator()(const value_type& x, const value_type& y) const {
+            return comp(x.first, y.first);
+        }
+    };
+
+private:
+    using rep_type = btree<key_type, value_type, std::_Select1st<value_type>, key_compare, Alloc>;
+    rep_type t;
+
+public:
+    using pointer = typename rep_type::pointer;
+    using const_pointer = typename rep_type::const_pointer;
+    using reference = typename rep_type::reference;
+    using const_reference = typename rep_type::const_reference;
+    using iterator = typename rep_type::iterator;
+    using const_iterator = typename rep_type::const_iterator;
+    using size_type = typename rep_type::size_type;
+    using difference_type = typename rep_type::difference_type;
+
+    btree_multimap() : t(Compare()) { }
+    explicit btree_multimap(const Compare& comp) : t(comp) { }
+    template <typename InputIterator>
+    btree_multimap(InputIterator first, InputIterator last) : t(Compare()) { t.insert_equal(first, last); }
+    template <typename InputIterator>
+    btree_multimap(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_equal(first, last); }
+    btree_multimap(const self& x) : t(x.t) { }
+    btree_multimap(self&& x) noexcept : t(std::move(x.t)) { }
+    self& operator=(const self& x) { t = x.t; return *this; }
+    self& operator=(self&& x) noexcept { t = std::move(x.t); return *this; }
+
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    static size_type max_size() { return rep_type::max_size(); }
+    void swap(self& x) noexcept { t.swap(x.t); }
+
+    iterator insert(const value_type& x) {
+        return t.insert_equal(x);
+    }
+    iterator insert(iterator position, const value_type& x) {
+        return t.insert_equal(position, x);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_equal(first, last);
+    }
+    iterator erase(iterator position) {
+        return t.erase(position);
+    }
+    size_type erase(const key_type& x) {
+        return t.erase(x);
+    }
+    void clear() { t.clear(); }
+
+    iterator find(const key_type& x) { return t.find(x); }
+    const_iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) { return t.lower_bound(x); }
+    const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
+    const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    std::pair<iterator, iterator> equal_range(const key_type& x) {
+        return t.equal_range(x);
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& x) const {
+        return t.equal_range(x);
+    }
+};
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "tiny_btree.h"
+#include "tiny_functional.h"
+#include <functional>
+
+namespace Tiny
+{
+
+// set and multiset with the interface of set, kept in a btree; unlike set,
+// any insert or erase invalidates every iterator, end() included
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class btree_set
+{
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using self = btree_set<Key, Compare, Alloc>;
+
+private:
+    using rep_type = btree<key_type, value_type, identity<value_type>, key_compare, Alloc>;
+    using rep_iterator = typename rep_type::iterator;
+    rep_type t;
+
+public:
+    using pointer = typename rep_type::const_pointer;
+    using const_pointer = typename rep_type::const_pointer;
+    using reference = typename rep_type::const_reference;
+    using const_reference = typename rep_type::const_reference;
+    using iterator = typename rep_type::const_iterator;
+    using const_iterator = typename rep_type::const_iterator;
+    using size_type = typename rep_type::size_type;
+    using difference_type = typename rep_type::difference_type;
+
+    btree_set() : t(Compare()) { }
+    explicit btree_set(const Compare& comp) : t(comp) { }
+    template <typename InputIterator>
+    btree_set(InputIterator first, InputIterator last) : t(Compare()) { t.insert_unique(first, last); }
+    template <typename InputIterator>
+    btree_set(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_unique(first, last); }
+    btree_set(const self& x) : t(x.t) { }
+    btree_set(self&& x) noexcept : t(std::move(x.t)) { }
+
+    self& operator=(const self& x) { t = x.t; return *this; }
+    self& operator=(self&& x) noexcept { t = std::move(x.t); return *this; }
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    static size_type max_size() { return rep_type::max_size(); }
+    void swap(self& x) noexcept { t.swap(x.t); }
+
+    using pair_iterator_bool = std::pair<iterator, bool>;
+    pair_iterator_bool insert(const value_type& x) {
+        std::pair<rep_iterator, bool> p = t.insert_unique(x);
+        return pair_iterator_bool(p.first, p.second);
+    }
+    iterator insert(iterator position, const value_type& x) {
+        return t.insert_unique(rep_iterator(position.node, position.position), x);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_unique(first, last);
+    }
+    iterator erase(iterator position) {
+        return t.erase(rep_iterator(position.node, position.position));
+    }
+    size_type erase(const key_type& x) {
+        return t.erase(x);
+    }
+    void clear() { t.clear(); }
+
+    iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) const {
+        return t.lower_bound(x);
+    }
+    iterator upper_bound(const key_type& x) const {
+        return t.upper_bound(x);
+    }
+    std::pair<iterator, iterator> equal_range(const key_type& x) const {
+        return t.equal_range(x);
+    }
+};
+
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class btree_multiset
+{
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using self = btree_multiset<Key, Compare, Alloc>;
+
+private:
+    using rep_type = btree<key_type, value_type, identity<value_type>, key_compare, Alloc>;
+    using rep_iterator = typename rep_type::iterator;
+    rep_type t;
+
+public:
+    using pointer = typename rep_type::const_pointer;
+    using const_pointer = typename rep_type::const_pointer;
+    using reference = typename rep_type::const_reference;
+    using const_reference = typename rep_type::const_reference;
+    using iterator = typename rep_type::const_iterator;
+    using const_iterator = typename rep_type::const_iterator;
+    using size_type = typename rep_type::size_type;
+    using difference_type = typename rep_type::difference_type;
+
+    btree_multiset() : t(Compare()) { }
+    explicit btree_multiset(const Compare& comp) : t(comp) { }
+    template <typename InputIterator>
+    btree_multiset(InputIterator first, InputIterator last) : t(Compare()) { t.insert_equal(first, last); }
+    template <typename InputIterator>
+    btree_multiset(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_equal(first, last); }
+    btree_multiset(const self& x) : t(x.t) { }
+    btree_multiset(self&& x) noexcept : t(std::move(x.t)) { }
+
+    self& operator=(const self& x) { t = x.t; return *this; }
+    self& operator=(self&& x) noexcept { t = std::move(x.t); return *this; }
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    static size_type max_size() { return rep_type::max_size(); }
+    void swap(self& x) noexcept { t.swap(x.t); }
+
+    iterator insert(const value_type& x) {
+        return t.insert_equal(x);
+    }
+    iterator insert(iterator position, const value_type& x) {
+        return t.insert_equal(rep_iterator(position.node, position.position), x);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_equal(first, last);
+    }
+    iterator erase(iterator position) {
+        return t.erase(rep_iterator(position.node, position.position));
+    }
+    size_type erase(const key_type& x) {
+        return t.erase(x);
+    }
+    void clear() { t.clear(); }
+
+    iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) const {
+        return t.lower_bound(x);
+    }
+    iterator upper_bound(const key_type& x) const {
+        return t.upper_bound(x);
+    }
+    std::pair<iterator, iterator> equal_range(const key_type& x) const {
+        return t.equal_range(x);
+    }
+};
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <iso646.h>
+
+namespace Tiny
+{
+
+// merge sort on a null-terminated chain of nodes linked through next, shared by
+// list and slist; value names the member that holds the element. If comp
+// throws, every node is still on the chain handed back, in no particular order
+
+template <typename Node>
+void __append_chain(Node*& a, Node* b)
+{
+    Node** tail = &a;
+    while (*tail != nullptr)
+        tail = &(*tail)->next;
+    *tail = b;
+}
+
+// merges b into a
+template <typename Node, typename T, typename Compare>
+void __merge_chain(Node*& a, Node* b, T Node::*value, Compare& comp)
+{
+    Node* head;
+    Node** tail = &head;
+    try {
+        while (a != nullptr and b != nullptr)
+        {
+            if (comp(b->*value, a->*value)) {
+                *tail = b;
+                tail = &b->next;
+                b = b->next;
+            }
+            else {
+                *tail = a;
+                tail = &a->next;
+                a = a->next;
+            }
+        }
+    }
+    catch (...) {
+        __append_chain(a, b);
+        *tail = a;
+        a = head;
+        throw;
+    }
+    *tail = a != nullptr ? a : b;
+    a = head;
+}
+
+// bottom-up, so it needs no recursion and stays stable
+template <typename Node, typename T, typename Compare>
+void __sort_chain(Node*& head, T Node::*value, Compare& comp)
+{
+    Node* counter[64] = { nullptr };
+    Node* carry = nullptr;
+    int fill = 0;
+    try {
+        while (head != nullptr)
+        {
+            carry = head;
+            head = head->next;
+            carry->next = nullptr;
+            int i;
+            for (i = 0; i < fill and counter[i] != nullptr; i++) {
+                Node* b = carry;
+                carry = nullptr;
+                __merge_chain(counter[i], b, value, comp);
+                carry = counter[i];
+                counter[i] = nullptr;
+            }
+            counter[i] = carry;
+            carry = nullptr;
+            if (i == fill) fill++;
+        }
+
+        for (int i = 1; i < fill; i++) {
+            Node* b = counter[i - 1];
+            counter[i - 1] = nullptr;
+            __merge_chain(counter[i], b, value, comp);
+        }
+    }
+    catch (...) {
+        __append_chain(carry, head);
+        for (int i = 0; i < fill; i++) {
+            __append_chain(counter[i], carry);
+            carry = counter[i];
+        }
+        head = carry;
+        throw;
+    }
+    head = fill > 0 ? counter[fill - 1] : nullptr;
+}
+
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <iso646.h>
+#include "tiny_alloc.h"
+#include "tiny_construct.h"
+#include "tiny_iterator.h"
+
+namespace Tiny
+{
+
+enum cb_full_policy { cb_overwrite, cb_reject };
+
+inline size_t __cb_capacity(size_t n) {
+    size_t result = 1;
+    while (result < n) result <<= 1;
+    return result;
+}
+
+// head and tail are free-running counters, masked only when the slot is touched;
+// the slots are rounded up to a power of two, but at most cap of them are in use
+
+template <typename T, typename Ref, typename Ptr>
+struct __circular_buffer_iterator
+{
+    using iterator = __circular_buffer_iterator<T, T&, T*>;
+    using const_iterator = __circular_buffer_iterator<T, const T&, const T*>;
+    using self = __circular_buffer_iterator<T, Ref, Ptr>;
+
+    using iterator_category = random_access_iterator_tag;
+    using value_type = T;
+    using pointer = Ptr;
+    using reference = Ref;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    T* buf;
+    size_type mask;
+    size_type pos;
+
+    __circular_buffer_iterator() = default;
+    __circular_buffer_iterator(T* b, size_type m, size_type p) : buf(b), mask(m), pos(p) { }
+    __circular_buffer_iterator(const iterator& x) : buf(x.buf), mask(x.mask), pos(x.pos) { }
+
+    reference operator*() const { return buf[pos & mask]; }
+    pointer operator->() const { return &(operator*()); }
+    reference operator[](difference_type n) const { return buf[(pos + n) & mask]; }
+    bool operator==(const self& x) const { return pos == x.pos; }
+    bool operator!=(const self& x) const { return pos != x.pos; }
+    bool operator<(const self& x) const { return difference_type(pos - x.pos) < 0; }
+    difference_type operator-(const self& x) const { return difference_type(pos - x.pos); }
+
+    self& operator++() {
+        pos++;
+        return *this;
+    }
+    self operator++(int) {
+        self tmp = *this;
+        pos++;
+        return tmp;
+    }
+    self& operator--() {
+        pos--;
+        return *this;
+    }
+    self operator--(int) {
+        self tmp = *this;
+        pos--;
+        return tmp;
+    }
+    self& operator+=(difference_type n) {
+        pos += n;
+        return *this;
+    }
+    self& operator-=(difference_type n) {
+        pos -= n;
+        return *this;
+    }
+    self operator+(difference_type n) const {
+        self tmp = *this;
+        return tmp += n;
+    }
+    self operator-(difference_type n) const {
+        self tmp = *this;
+        return tmp -= n;
+    }
+};
+
+template <typename T, typename Alloc = alloc>
+class circular_buffer
+{
+public:
+    using value_type = T;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = __circular_buffer_iterator<T, T&, T*>;
+    using const_iterator = __circular_buffer_iterator<T, const T&, const T*>;
+    using array_range = std::pair<pointer, size_type>;
+    using const_array_range = std::pair<const_pointer, size_type>;
+
+protected:
+    using data_allocator = simple_alloc<value_type, Alloc>;
+    pointer buf;
+    size_type mask;
+    size_type cap;
+    size_type head;
+    size_type tail;
+    cb_full_policy policy;
+
+    static const size_type default_capacity = 16;
+
+    void allocate_buffer(size_type n) {
+        buf = data_allocator::allocate(__cb_capacity(n));
+        mask = __cb_capacity(n) - 1;
+        cap = n;
+        head = tail = 0;
+    }
+    void deallocate_buffer() {
+        if (buf == nullptr) return;
+        data_allocator::deallocate(buf, mask + 1);
+    }
+
+public:
+    iterator begin() { return iterator(buf, mask, head); }
+    iterator end() { return iterator(buf, mask, tail); }
+    const_iterator begin() const { return const_iterator(buf, mask, head); }
+    const_iterator end() const { return const_iterator(buf, mask, tail); }
+    size_type size() const { return tail - head; }
+    size_type capacity() const { return cap; }
+    size_type max_size() const { return capacity(); }
+    bool empty() const { return tail == head; }
+    bool full() const { return tail - head == cap; }
+    cb_full_policy full_policy() const { return policy; }
+    void set_full_policy(cb_full_policy p) { policy = p; }
+
+    reference operator[](size_type n) { return buf[(head + n) & mask]; }
+    reference front() { return buf[head & mask]; }
+    reference back() { return buf[(tail - 1) & mask]; }
+    const_reference operator[](size_type n) const { return buf[(head + n) & mask]; }
+    const_reference front() const { return buf[head & mask]; }
+    const_reference back() const { return buf[(tail - 1) & mask]; }
+
+    explicit circular_buffer(size_type n = default_capacity, cb_full_policy p = cb_overwrite)
+        : policy(p) { allocate_buffer(n); }
+    circular_buffer(const circular_buffer&);
+    circular_buffer(circular_buffer&&);
+    ~circular_buffer() {
+        clear();
+        deallocate_buffer();
+    }
+    circular_buffer& operator=(const circular_buffer&);
+    void swap(circular_buffer&);
+
+    array_range array_one();
+    array_range array_two();
+    const_array_range array_one() const;
+    const_array_range array_two() const;
+
+    bool push_back(const T&);
+    bool push_front(const T&);
+    void pop_front() {
+        Tiny::destroy(&buf[head & mask]);
+        head++;
+    }
+    void pop_back() {
+        tail--;
+        Tiny::destroy(&buf[tail & mask]);
+    }
+    void clear();
+};
+
+template <typename T, typename Alloc>
+circular_buffer<T, Alloc>::circular_buffer(const circular_buffer& x) : policy(x.policy)
+{
+    allocate_buffer(x.capacity());
+    try {
+        for (const T& item : x) {
+            construct(&buf[tail & mask], item);
+            tail++;
+        }
+    }
+    catch (...) {
+        clear();
+        deallocate_buffer();
+        throw;
+    }
+}
+
+template <typename T, typename Alloc>
+circular_buffer<T, Alloc>::circular_buffer(circular_buffer&& x)
+    : buf(x.buf), mask(x.mask), cap(x.cap), head(x.head), tail(x.tail), policy(x.policy)
+{
+    x.buf = nullptr;
+    x.mask = 0;
+    x.cap = 0;
+    x.head = x.tail = 0;
+}
+
+template <typename T, typename Alloc>
+circular_buffer<T, Alloc>& circular_buffer<T, Alloc>::operator=(const circular_buffer& x)
+{
+    if (this == &x) return *this;
+    circular_buffer tmp(x);
+    swap(tmp);
+    return *this;
+}
+
+template <typename T, typename Alloc>
+void circular_buffer<T, Alloc>::swap(circular_buffer& x)
+{
+    std::swap(buf, x.buf);
+    std::swap(mask, x.mask);
+    std::swap(cap, x.cap);
+    std::swap(head, x.head);
+    std::swap(tail, x.tail);
+    std::swap(policy, x.policy);
+}
+
+template <typename T, typename Alloc>
+auto circular_buffer<T, Alloc>::array_one() -> array_range
+{
+    size_type first = head & mask;
+    return { buf + first, std::min(size(), mask + 1 - first) };
+}
+
+template <typename T, typename Alloc>
+auto circular_buffer<T, Alloc>::array_two() -> array_range
+{
+    size_type first = head & mask;
+    size_type n = size();
+    return { buf, n > mask + 1 - first ? n - (mask + 1 - first) : 0 };
+}
+
+template <typename T, typename Alloc>
+auto circular_buffer<T, Alloc>::array_one() const -> const_array_range
+{
+    size_type first = head & mask;
+    return { buf + first, std::min(size(), mask + 1 - first) };
+}
+
+template <typename T, typename Alloc>
+auto circular_buffer<T, Alloc>::array_two() const -> const_array_range
+{
+    size_type first = head & mask;
+    size_type n = size();
+    return { buf, n > mask + 1 - first ? n - (mask + 1 - first) : 0 };
+}
+
+template <typename T, typename Alloc>
+bool circular_buffer<T, Alloc>::push_back(const T& x)
+{
+    if (full()) {
+        if (policy == cb_reject or cap == 0) return false;
+        if ((tail & mask) == (head & mask))
+            buf[head & mask] = x;
+        else {
+            construct(&buf[tail & mask], x);
+            Tiny::destroy(&buf[head & mask]);
+        }
+        head++;
+        tail++;
+        return true;
+    }
+    construct(&buf[tail & mask], x);
+    tail++;
+    return true;
+}
+
+template <typename T, typename Alloc>
+bool circular_buffer<T, Alloc>::push_front(const T& x)
+{
+    if (full()) {
+        if (policy == cb_reject or cap == 0) return false;
+        if (((head - 1) & mask) == ((tail - 1) & mask))
+            buf[(head - 1) & mask] = x;
+        else {
+            construct(&buf[(head - 1) & mask], x);
+            Tiny::destroy(&buf[(tail - 1) & mask]);
+        }
+        head--;
+        tail--;
+        return true;
+    }
+    construct(&buf[(head - 1) & mask], x);
+    head--;
+    return true;
+}
+
+template <typename T, typename Alloc>
+void circular_buffer<T, Alloc>::clear()
+{
+    array_range one = array_one();
+    array_range two = array_two();
+    Tiny::destroy(one.first, one.first + one.second);
+    Tiny::destroy(two.first, two.first + two.second);
+    head = tail = 0;
+}
+
+}
@@ -0,0 +1,462 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+#include <utility>
+#include "tiny_alloc.h"
+#include "tiny_construct.h"
+#include "tiny_iterator.h"
+#include "tiny_sync.h"
+#include "tiny_epoch.h"
+
+namespace Tiny
+{
+
+// ordered map shared between threads, for read-mostly use: a lazy skip list
+// after Herlihy, Lev, Luchangco and Shavit. Lookups and iteration take no
+// locks and never retry; insert and erase lock only the predecessors of the
+// node they link or unlink, and erased nodes are freed through the epochs of
+// tiny_epoch.h. An iterator pins the epoch, so the element it refers to stays
+// readable while the iterator lives; it belongs to the thread that made it.
+// Elements are read-only once inserted.
+
+template <typename Value>
+struct __skip_list_node : public __epoch_retired
+{
+    using link_type = __skip_list_node<Value>*;
+
+    std::atomic<link_type>* next;     // height links, stored after the node
+    int height;
+    std::atomic<bool> marked;         // erased, about to be unlinked
+    std::atomic<bool> fully_linked;   // linked at every level
+    __spin_lock lock;
+    Value value;                      // left unconstructed in the head
+};
+
+// skips nodes that are being inserted or erased
+template <typename Value>
+__skip_list_node<Value>* __skip_list_live(__skip_list_node<Value>* x)
+{
+    while (x != nullptr and (x->marked.load(std::memory_order_acquire)
+                             or !x->fully_linked.load(std::memory_order_acquire)))
+        x = x->next[0].load(std::memory_order_acquire);
+    return x;
+}
+
+template <typename Value>
+struct __skip_list_iterator
+{
+    using self = __skip_list_iterator<Value>;
+
+    using iterator_category = forward_iterator_tag;
+    using value_type = Value;
+    using pointer = const Value*;
+    using reference = const Value&;
+    using link_type = __skip_list_node<Value>*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    link_type node;
+    __epoch_record* record;   // pinned unless null
+
+    __skip_list_iterator() : node(nullptr), record(nullptr) { }
+    __skip_list_iterator(link_type x, __epoch_record* r) : node(x), record(x != nullptr ? r : nullptr) {
+        if (record != nullptr) __epoch_global_domain().pin(record);
+    }
+    __skip_list_iterator(const self& x) : node(x.node), record(x.record) {
+        if (record != nullptr) __epoch_global_domain().pin(record);
+    }
+    self& operator=(const self& x) {
+        if (x.record != nullptr) __epoch_global_domain().pin(x.record);
+        if (record != nullptr) __epoch_global_domain().unpin(record);
+        node = x.node;
+        record = x.record;
+        return *this;
+    }
+    ~__skip_list_iterator() {
+        if (record != nullptr) __epoch_global_domain().unpin(record);
+    }
+
+    bool operator==(const self& x) const { return node == x.node; }
+    bool operator!=(const self& x) const { return node != x.node; }
+    reference operator*() const { return node->value; }
+    pointer operator->() const { return &operator*(); }
+
+    self& operator++() {
+        node = __skip_list_live(node->next[0].load(std::memory_order_acquire));
+        return *this;
+    }
+    self operator++(int) {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+};
+
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = malloc_alloc>
+class concurrent_map
+{
+public:
+    using key_type = Key;
+    using data_type = T;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using key_compare = Compare;
+    using const_reference = const value_type&;
+    using const_iterator = __skip_list_iterator<value_type>;
+    using iterator = const_iterator;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using pair_iterator_bool = std::pair<iterator, bool>;
+
+protected:
+    using node = __skip_list_node<value_type>;
+    using link_type = node*;
+    using link_slot = std::atomic<link_type>;
+
+    // each level keeps a quarter of the one below, enough for 4^20 elements
+    static const int max_height = 20;
+
+    link_type head;
+    Compare comp;
+    alignas(__cache_line_size) std::atomic<size_type> node_count;
+
+    static size_t node_size(int h) { return sizeof(node) + h * sizeof(link_slot); }
+    static link_type get_node(int h);
+    static void put_node(link_type p) { Alloc::deallocate(p, node_size(p->height)); }
+    template <typename V>
+    static link_type create_node(int h, V&& x);
+    static void destroy_node(link_type p) {
+        Tiny::destroy(&p->value);
+        put_node(p);
+    }
+    static void reclaim_node(__epoch_retired* p) { destroy_node(static_cast<link_type>(p)); }
+    static int random_height();
+    static const Key& key(link_type x) { return x->value.first; }
+    static void unlock_preds(link_type* preds, int highest);
+    void destroy_nodes() {
+        link_type x = head->next[0].load(std::memory_order_acquire);
+        while (x != nullptr) {
+            link_type next = x->next[0].load(std::memory_order_relaxed);
+            destroy_node(x);
+            x = next;
+        }
+        put_node(head);
+    }
+
+    int find_node(const Key& k, link_type* preds, link_type* succs) const;
+    link_type lower_node(const Key& k) const;
+    link_type upper_node(const Key& k) const;
+    template <typename V>
+    pair_iterator_bool insert_value(V&& x);
+
+public:
+    concurrent_map() : head(get_node(max_height)), comp(Compare()), node_count(0) { }
+    explicit concurrent_map(const Compare& c) : head(get_node(max_height)), comp(c), node_count(0) { }
+    template <typename InputIterator>
+    concurrent_map(InputIterator first, InputIterator last)
+        : head(get_node(max_height)), comp(Compare()), node_count(0) {
+        try {
+            insert(first, last);
+        }
+        catch (...) {
+            destroy_nodes();
+            throw;
+        }
+    }
+    concurrent_map(const concurrent_map&) = delete;
+    concurrent_map& operator=(const concurrent_map&) = delete;
+    // no other thread may be using the map
+    ~concurrent_map() { destroy_nodes(); }
+
+    key_compare key_comp() const { return comp; }
+    // exact while no insert or erase is in flight
+    size_type size() const { return node_count.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+
+    const_iterator begin() const {
+        __epoch_guard guard;
+        return const_iterator(__skip_list_live(head->next[0].load(std::memory_order_acquire)), guard.get());
+    }
+    const_iterator end() const { return const_iterator(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    pair_iterator_bool insert(const value_type& x) { return insert_value(x); }
+    pair_iterator_bool insert(value_type&& x) { return insert_value(std::move(x)); }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        for (; first != last; first++)
+            insert_value(*first);
+    }
+    size_type erase(const key_type& k);
+    void erase(const_iterator position) { erase(position->first); }
+    // safe to run alongside other operations, but not atomic with them
+    void clear();
+
+    const_iterator find(const key_type& k) const;
+    size_type count(const key_type& k) const;
+    const_iterator lower_bound(const key_type& k) const {
+        __epoch_guard guard;
+        return const_iterator(lower_node(k), guard.get());
+    }
+    const_iterator upper_bound(const key_type& k) const {
+        __epoch_guard guard;
+        return const_iterator(upper_node(k), guard.get());
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+        const_iterator first = find(k);
+        const_iterator last = first;
+        if (first != end()) ++last;
+        return std::pair<const_iterator, const_iterator>(first, last);
+    }
+};
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+auto concurrent_map<Key, T, Compare, Alloc>::get_node(int h) -> link_type
+{
+    link_type p = static_cast<link_type>(Alloc::allocate(node_size(h)));
+    p->reclaim = &reclaim_node;
+    p->next = reinterpret_cast<link_slot*>(p + 1);
+    for (int i = 0; i < h; i++)
+        new(&p->next[i]) link_slot(nullptr);
+    p->height = h;
+    new(&p->marked) std::atomic<bool>(false);
+    new(&p->fully_linked) std::atomic<bool>(false);
+    new(&p->lock) __spin_lock();
+    return p;
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+template <typename V>
+auto concurrent_map<Key, T, Compare, Alloc>::create_node(int h, V&& x) -> link_type
+{
+    link_type p = get_node(h);
+    try {
+        construct(&p->value, std::forward<V>(x));
+    }
+    catch (...) {
+        put_node(p);
+        throw;
+    }
+    return p;
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+int concurrent_map<Key, T, Compare, Alloc>::random_height()
+{
+    thread_local uint64_t seed = reinterpret_cast<uintptr_t>(&seed) | 1;
+    seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+    uint64_t r = seed;
+    int h = 1;
+    while (h < max_height and (r & 3) == 0) {
+        h++;
+        r >>= 2;
+    }
+    return h;
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+void concurrent_map<Key, T, Compare, Alloc>::unlock_preds(link_type* preds, int highest)
+{
+    link_type prev = nullptr;
+    for (int level = 0; level <= highest; level++)
+        if (preds[level] != prev) {
+            preds[level]->lock.unlock();
+            prev = preds[level];
+        }
+}
+
+// fills in the last node before k and the one after it at every level;
+// returns the highest level k was found at, or -1
+template <typename Key, typename T, typename Compare, typename Alloc>
+int concurrent_map<Key, T, Compare, Alloc>::find_node(const Key& k, link_type* preds, link_type* succs) const
+{
+    int found = -1;
+    link_type pred = head;
+    for (int level = max_height - 1; level >= 0; level--) {
+        link_type cur = pred->next[level].load(std::memory_order_acquire);
+        while (cur != nullptr and comp(key(cur), k)) {
+            pred = cur;
+            cur = pred->next[level].load(std::memory_order_acquire);
+        }
+        if (found == -1 and cur != nullptr and !comp(k, key(cur)))
+            found = level;
+        preds[level] = pred;
+        succs[level] = cur;
+    }
+    return found;
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+auto concurrent_map<Key, T, Compare, Alloc>::lower_node(const Key& k) const -> link_type
+{
+    link_type pred = head, cur = nullptr;
+    for (int level = max_height - 1; level >= 0; level--) {
+        cur = pred->next[level].load(std::memory_order_acquire);
+        while (cur != nullptr and comp(key(cur), k)) {
+            pred = cur;
+            cur = pred->next[level].load(std::memory_order_acquire);
+        }
+    }
+    return __skip_list_live(cur);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+auto concurrent_map<Key, T, Compare, Alloc>::upper_node(const Key& k) const -> link_type
+{
+    link_type pred = head, cur = nullptr;
+    for (int level = max_height - 1; level >= 0; level--) {
+        cur = pred->next[level].load(std::memory_order_acquire);
+        while (cur != nullptr and !comp(k, key(cur))) {
+            pred = cur;
+            cur = pred->next[level].load(std::memory_order_acquire);
+        }
+    }
+    return __skip_list_live(cur);
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+template <typename V>
+auto concurrent_map<Key, T, Compare, Alloc>::insert_value(V&& x) -> pair_iterator_bool
+{
+    __epoch_guard guard;
+    link_type preds[max_height], succs[max_height];
+    link_type z = nullptr;
+    const Key* k = &x.first;
+    int height = random_height();
+    while (true)
+    {
+        int found = find_node(*k, preds, succs);
+        if (found != -1) {
+            link_type y = succs[found];
+            if (!y->marked.load(std::memory_order_acquire)) {
+                unsigned spins = 0;
+                while (!y->fully_linked.load(std::memory_order_acquire))
+                    if (++spins >= 64)
+                        std::this_thread::yield();
+                if (z != nullptr) destroy_node(z);
+                return pair_iterator_bool(iterator(y, guard.get()), false);
+            }
+            // wait for the erase to unlink it
+            continue;
+        }
+        if (z == nullptr) {
+            z = create_node(height, std::forward<V>(x));
+            k = &key(z);
+        }
+
+        int highest = -1;
+        link_type prev = nullptr;
+        bool valid = true;
+        for (int level = 0; valid and level < height; level++) {
+            link_type pred = preds[level], succ = succs[level];
+            if (pred != prev) {
+                pred->lock.lock();
+                highest = level;
+                prev = pred;
+            }
+            valid = !pred->marked.load(std::memory_order_acquire)
+                    and (succ == nullptr or !succ->marked.load(std::memory_order_acquire))
+                    and pred->next[level].load(std::memory_order_acquire) == succ;
+        }
+        if (!valid) {
+            unlock_preds(preds, highest);
+            continue;
+        }
+
+        for (int level = 0; level < height; level++)
+            z->next[level].store(succs[level], std::memory_order_relaxed);
+        for (int level = 0; level < height; level++)
+            preds[level]->next[level].store(z, std::memory_order_release);
+        z->fully_linked.store(true, std::memory_order_release);
+        unlock_preds(preds, highest);
+        node_count.fetch_add(1, std::memory_order_relaxed);
+        return pair_iterator_bool(iterator(z, guard.get()), true);
+    }
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+auto concurrent_map<Key, T, Compare, Alloc>::erase(const key_type& k) -> size_type
+{
+    __epoch_guard guard;
+    link_type preds[max_height], succs[max_height];
+    link_type victim = nullptr;
+    int height = 0;
+    while (true)
+    {
+        int found = find_node(k, preds, succs);
+        if (victim == nullptr) {
+            if (found == -1) return 0;
+            link_type y = succs[found];
+            if (!y->fully_linked.load(std::memory_order_acquire) or y->height - 1 != found
+                or y->marked.load(std::memory_order_acquire))
+                return 0;
+            y->lock.lock();
+            if (y->marked.load(std::memory_order_relaxed)) {
+                y->lock.unlock();
+                return 0;
+            }
+            y->marked.store(true, std::memory_order_release);
+            victim = y;
+            height = y->height;
+        }
+
+        int highest = -1;
+        link_type prev = nullptr;
+        bool valid = true;
+        for (int level = 0; valid and level < height; level++) {
+            link_type pred = preds[level];
+            if (pred != prev) {
+                pred->lock.lock();
+                highest = level;
+                prev = pred;
+            }
+            valid = !pred->marked.load(std::memory_order_acquire)
+                    and pred->next[level].load(std::memory_order_acquire) == victim;
+        }
+        if (!valid) {
+            unlock_preds(preds, highest);
+            continue;
+        }
+
+        for (int level = height - 1; level >= 0; level--)
+            preds[level]->next[level].store(victim->next[level].load(std::memory_order_relaxed),
+                                            std::memory_order_release);
+        victim->lock.unlock();
+        unlock_preds(preds, highest);
+        node_count.fetch_sub(1, std::memory_order_relaxed);
+        __epoch_global_domain().retire(guard.get(), victim);
+        return 1;
+    }
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+void concurrent_map<Key, T, Compare, Alloc>::clear()
+{
+    __epoch_guard guard;
+    link_type x;
+    while ((x = __skip_list_live(head->next[0].load(std::memory_order_acquire))) != nullptr)
+        erase(key(x));
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+auto concurrent_map<Key, T, Compare, Alloc>::find(const key_type& k) const -> const_iterator
+{
+    __epoch_guard guard;
+    link_type x = lower_node(k);
+    return const_iterator(x == nullptr or comp(k, key(x)) ? nullptr : x, guard.get());
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+auto concurrent_map<Key, T, Compare, Alloc>::count(const key_type& k) const -> size_type
+{
+    __epoch_guard guard;
+    link_type x = lower_node(k);
+    return x == nullptr or comp(k, key(x)) ? 0 : 1;
+}
+
+}
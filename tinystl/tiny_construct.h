@@ -1,16 +1,18 @@
 #pragma once
 
 #include <new>                  // for placement new
+#include <utility>              // for forward()
 #include "tiny_type_traits.h"   // for __type_traits, __true_type, __false_type
 #include "tiny_iterator.h"
 
 namespace Tiny
 {
 
+// forwards, so an rvalue argument is moved into place
 template <class T1, class T2>
-void construct(T1* p, const T2& value) {
+void construct(T1* p, T2&& value) {
     if (p == nullptr) return;
-    new(p) T1(value);
+    new(p) T1(std::forward<T2>(value));
 }
 
 template <class T>
@@ -3,6 +3,7 @@
 // waiting for copy(), copy_backward(), max;
 
 #include <algorithm>
+#include <numeric>
 #include "tiny_alloc.h"
 #include "tiny_construct.h"
 #include "tiny_uninitialized.h"
@@ -115,6 +116,179 @@ struct __deque_iterator
     }
 };
 
+// segmented algorithms: each buffer of a deque is processed as a plain array
+
+template <typename T, size_t BufSiz>
+__deque_iterator<T, T&, T*, BufSiz> __copy_to_deque(const T* first, const T* last,
+                                                    __deque_iterator<T, T&, T*, BufSiz> result)
+{
+    while (first != last) {
+        ptrdiff_t n = std::min(last - first, result.last - result.cur);
+        std::copy(first, first + n, result.cur);
+        first += n;
+        result += n;
+    }
+    return result;
+}
+
+template <typename T, size_t BufSiz>
+__deque_iterator<T, T&, T*, BufSiz> __copy_backward_to_deque(const T* first, const T* last,
+                                                             __deque_iterator<T, T&, T*, BufSiz> result)
+{
+    while (first != last) {
+        ptrdiff_t room = result.cur - result.first;
+        if (room == 0) {
+            result.set_node(result.node - 1);
+            result.cur = result.last;
+            room = result.last - result.first;
+        }
+        ptrdiff_t n = std::min(last - first, room);
+        std::copy_backward(last - n, last, result.cur);
+        last -= n;
+        result.cur -= n;
+    }
+    return result;
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename OutputIterator>
+OutputIterator copy(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+                    __deque_iterator<T, Ref, Ptr, BufSiz> last, OutputIterator result)
+{
+    if (first.node == last.node)
+        return std::copy(first.cur, last.cur, result);
+    result = std::copy(first.cur, first.last, result);
+    for (T** node = first.node + 1; node < last.node; node++)
+        result = std::copy(*node, *node + first.buffer_size(), result);
+    return std::copy(last.first, last.cur, result);
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz>
+__deque_iterator<T, T&, T*, BufSiz> copy(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+                                         __deque_iterator<T, Ref, Ptr, BufSiz> last,
+                                         __deque_iterator<T, T&, T*, BufSiz> result)
+{
+    if (first.node == last.node)
+        return __copy_to_deque(first.cur, last.cur, result);
+    result = __copy_to_deque(first.cur, first.last, result);
+    for (T** node = first.node + 1; node < last.node; node++)
+        result = __copy_to_deque(*node, *node + first.buffer_size(), result);
+    return __copy_to_deque(last.first, last.cur, result);
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename BidirectionalIterator>
+BidirectionalIterator copy_backward(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+                                    __deque_iterator<T, Ref, Ptr, BufSiz> last,
+                                    BidirectionalIterator result)
+{
+    if (first.node == last.node)
+        return std::copy_backward(first.cur, last.cur, result);
+    result = std::copy_backward(last.first, last.cur, result);
+    for (T** node = last.node - 1; node > first.node; node--)
+        result = std::copy_backward(*node, *node + first.buffer_size(), result);
+    return std::copy_backward(first.cur, first.last, result);
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz>
+__deque_iterator<T, T&, T*, BufSiz> copy_backward(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+                                                  __deque_iterator<T, Ref, Ptr, BufSiz> last,
+                                                  __deque_iterator<T, T&, T*, BufSiz> result)
+{
+    if (first.node == last.node)
+        return __copy_backward_to_deque(first.cur, last.cur, result);
+    result = __copy_backward_to_deque(last.first, last.cur, result);
+    for (T** node = last.node - 1; node > first.node; node--)
+        result = __copy_backward_to_deque(*node, *node + first.buffer_size(), result);
+    return __copy_backward_to_deque(first.cur, first.last, result);
+}
+
+template <typename T, size_t BufSiz>
+void fill(__deque_iterator<T, T&, T*, BufSiz> first,
+          __deque_iterator<T, T&, T*, BufSiz> last, const T& value)
+{
+    if (first.node == last.node) {
+        std::fill(first.cur, last.cur, value);
+        return;
+    }
+    std::fill(first.cur, first.last, value);
+    for (T** node = first.node + 1; node < last.node; node++)
+        std::fill(*node, *node + first.buffer_size(), value);
+    std::fill(last.first, last.cur, value);
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename U>
+__deque_iterator<T, Ref, Ptr, BufSiz> find(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+                                           __deque_iterator<T, Ref, Ptr, BufSiz> last, const U& value)
+{
+    if (first.node == last.node) {
+        first.cur = std::find(first.cur, last.cur, value);
+        return first;
+    }
+    T* pos = std::find(first.cur, first.last, value);
+    if (pos != first.last) {
+        first.cur = pos;
+        return first;
+    }
+    for (T** node = first.node + 1; node < last.node; node++) {
+        T* node_last = *node + first.buffer_size();
+        pos = std::find(*node, node_last, value);
+        if (pos != node_last) {
+            first.set_node(node);
+            first.cur = pos;
+            return first;
+        }
+    }
+    last.cur = std::find(last.first, last.cur, value);
+    return last;
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename U>
+ptrdiff_t count(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+                __deque_iterator<T, Ref, Ptr, BufSiz> last, const U& value)
+{
+    if (first.node == last.node)
+        return std::count(first.cur, last.cur, value);
+    ptrdiff_t n = std::count(first.cur, first.last, value);
+    for (T** node = first.node + 1; node < last.node; node++)
+        n += std::count(*node, *node + first.buffer_size(), value);
+    return n + std::count(last.first, last.cur, value);
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename Function>
+Function for_each(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+                  __deque_iterator<T, Ref, Ptr, BufSiz> last, Function f)
+{
+    if (first.node == last.node)
+        return std::for_each(first.cur, last.cur, f);
+    f = std::for_each(first.cur, first.last, f);
+    for (T** node = first.node + 1; node < last.node; node++)
+        f = std::for_each(*node, *node + first.buffer_size(), f);
+    return std::for_each(last.first, last.cur, f);
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename U>
+U accumulate(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+             __deque_iterator<T, Ref, Ptr, BufSiz> last, U init)
+{
+    if (first.node == last.node)
+        return std::accumulate(first.cur, last.cur, init);
+    init = std::accumulate(first.cur, first.last, init);
+    for (T** node = first.node + 1; node < last.node; node++)
+        init = std::accumulate(*node, *node + first.buffer_size(), init);
+    return std::accumulate(last.first, last.cur, init);
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename U, typename BinaryOperation>
+U accumulate(__deque_iterator<T, Ref, Ptr, BufSiz> first,
+             __deque_iterator<T, Ref, Ptr, BufSiz> last, U init, BinaryOperation op)
+{
+    if (first.node == last.node)
+        return std::accumulate(first.cur, last.cur, init, op);
+    init = std::accumulate(first.cur, first.last, init, op);
+    for (T** node = first.node + 1; node < last.node; node++)
+        init = std::accumulate(*node, *node + first.buffer_size(), init, op);
+    return std::accumulate(last.first, last.cur, init, op);
+}
+
 template <typename T, typename Alloc = alloc, size_t BufSiz = 512>
 class deque
 {
@@ -264,7 +438,7 @@ void deque<T, Alloc, BufSiz>::reallocate_map(size_type nodes_to_add, bool add_at
         if (new_nstart < start.node)
             std::copy(start.node, finish.node + 1, new_nstart);
         else
-            std::copy_backward(start.node, finish.node + 1, new_nstart);
+            std::copy_backward(start.node, finish.node + 1, new_nstart + old_num_nodes);
     }
     else
     {
@@ -280,7 +454,7 @@ void deque<T, Alloc, BufSiz>::reallocate_map(size_type nodes_to_add, bool add_at
     }
 
     start.set_node(new_nstart);
-    finish.set_node(new_nstart + old_num_nodes + 1);
+    finish.set_node(new_nstart + old_num_nodes - 1);
 }
 
 
@@ -294,15 +468,15 @@ void deque<T, Alloc, BufSiz>::deallocate_map()
 template <typename T, typename Alloc, size_t BufSiz>
 void deque<T, Alloc, BufSiz>::reverse_map_at_front(size_type nodes_to_add)
 {
-    if (nodes_to_add >= map_size - (finish.node - map))
-        reallocate_map(nodes_to_add, false);
+    if (nodes_to_add > size_type(start.node - map))
+        reallocate_map(nodes_to_add, true);
 }
 
 template <typename T, typename Alloc, size_t BufSiz>
 void deque<T, Alloc, BufSiz>::reverse_map_at_back(size_type nodes_to_add)
 {
-    if (nodes_to_add > start.node - map)
-        reallocate_map(nodes_to_add, true);
+    if (nodes_to_add + 1 > map_size - (finish.node - map))
+        reallocate_map(nodes_to_add, false);
 }
 
 template <typename T, typename Alloc, size_t BufSiz>
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include "tiny_alloc.h"
+#include "tiny_construct.h"
+#include "tiny_sync.h"
+
+namespace Tiny
+{
+
+// epoch-based reclamation shared by the lock-free readers of the concurrent
+// containers. A reader pins the global epoch for the length of an operation;
+// a node unlinked while the epoch was e is freed once the epoch reaches e + 2,
+// by then every thread has unpinned at least once since the unlink
+
+struct __epoch_retired
+{
+    __epoch_retired* retire_next;
+    void (*reclaim)(__epoch_retired*);
+};
+
+struct __epoch_record
+{
+    // epoch << 1 | 1 while pinned, 0 otherwise
+    std::atomic<size_t> state;
+    std::atomic<bool> in_use;
+    __epoch_record* next;
+    unsigned nesting;
+    size_t retired;
+    // nodes retired in epoch bag_epoch[i], with i == bag_epoch[i] % 3
+    __epoch_retired* bag[3];
+    size_t bag_epoch[3];
+
+    __epoch_record() : state(0), in_use(true), next(nullptr), nesting(0), retired(0),
+                       bag{ nullptr, nullptr, nullptr }, bag_epoch{ 0, 0, 0 } { }
+};
+
+class __epoch_domain
+{
+protected:
+    using record_allocator = simple_alloc<__epoch_record, malloc_alloc>;
+
+    alignas(__cache_line_size) std::atomic<size_t> epoch;
+    std::atomic<__epoch_record*> records;
+
+    static const size_t advance_interval = 64;
+
+    static void free_bag(__epoch_retired* p) {
+        while (p != nullptr) {
+            __epoch_retired* next = p->retire_next;
+            p->reclaim(p);
+            p = next;
+        }
+    }
+    void try_advance();
+    void collect(__epoch_record* r);
+
+public:
+    __epoch_domain() : epoch(0), records(nullptr) { }
+    __epoch_domain(const __epoch_domain&) = delete;
+    __epoch_domain& operator=(const __epoch_domain&) = delete;
+    // runs at exit, after every thread has released its record
+    ~__epoch_domain() {
+        __epoch_record* r = records.load(std::memory_order_acquire);
+        while (r != nullptr) {
+            __epoch_record* next = r->next;
+            for (int i = 0; i < 3; i++)
+                free_bag(r->bag[i]);
+            destroy(r);
+            record_allocator::deallocate(r);
+            r = next;
+        }
+    }
+
+    __epoch_record* acquire();
+    // a released record keeps its bags; the next thread to take it frees them
+    void release(__epoch_record* r) { r->in_use.store(false, std::memory_order_release); }
+
+    void pin(__epoch_record* r) {
+        if (r->nesting++ != 0) return;
+        r->state.store(epoch.load(std::memory_order_acquire) << 1 | 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    void unpin(__epoch_record* r) {
+        if (--r->nesting == 0)
+            r->state.store(0, std::memory_order_release);
+    }
+    // p must already be unreachable for threads that pin from now on
+    void retire(__epoch_record* r, __epoch_retired* p);
+};
+
+inline __epoch_record* __epoch_domain::acquire()
+{
+    for (__epoch_record* r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+        bool expected = false;
+        if (!r->in_use.load(std::memory_order_relaxed)
+            and r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return r;
+    }
+    __epoch_record* r = record_allocator::allocate();
+    new(r) __epoch_record();
+    __epoch_record* head = records.load(std::memory_order_relaxed);
+    do r->next = head;
+    while (!records.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+    return r;
+}
+
+// moves the epoch on when every pinned thread has seen the current one
+inline void __epoch_domain::try_advance()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    size_t e = epoch.load(std::memory_order_relaxed);
+    for (__epoch_record* r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+        size_t s = r->state.load(std::memory_order_acquire);
+        if ((s & 1) and (s >> 1) != e)
+            return;
+    }
+    epoch.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+}
+
+inline void __epoch_domain::collect(__epoch_record* r)
+{
+    size_t e = epoch.load(std::memory_order_acquire);
+    for (int i = 0; i < 3; i++)
+        if (r->bag[i] != nullptr and e - r->bag_epoch[i] >= 2) {
+            free_bag(r->bag[i]);
+            r->bag[i] = nullptr;
+        }
+}
+
+inline void __epoch_domain::retire(__epoch_record* r, __epoch_retired* p)
+{
+    // the unlink must be visible before the epoch is read, or p could be
+    // tagged with an epoch older than a reader that still sees it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    size_t e = epoch.load(std::memory_order_relaxed);
+    int i = e % 3;
+    if (r->bag_epoch[i] != e) {
+        // left over from epoch e - 3 or earlier
+        free_bag(r->bag[i]);
+        r->bag[i] = nullptr;
+        r->bag_epoch[i] = e;
+    }
+    p->retire_next = r->bag[i];
+    r->bag[i] = p;
+    if (++r->retired % advance_interval == 0) {
+        try_advance();
+        collect(r);
+    }
+}
+
+inline __epoch_domain& __epoch_global_domain()
+{
+    static __epoch_domain domain;
+    return domain;
+}
+
+struct __epoch_thread
+{
+    __epoch_record* record;
+
+    __epoch_thread() : record(__epoch_global_domain().acquire()) { }
+    ~__epoch_thread() { __epoch_global_domain().release(record); }
+};
+
+inline __epoch_record* __epoch_this_thread()
+{
+    thread_local __epoch_thread t;
+    return t.record;
+}
+
+// pins the calling thread for the lifetime of the guard
+class __epoch_guard
+{
+    __epoch_record* record;
+
+public:
+    __epoch_guard() : record(__epoch_this_thread()) { __epoch_global_domain().pin(record); }
+    __epoch_guard(const __epoch_guard&) = delete;
+    __epoch_guard& operator=(const __epoch_guard&) = delete;
+    ~__epoch_guard() { __epoch_global_domain().unpin(record); }
+
+    __epoch_record* get() const { return record; }
+};
+
+}
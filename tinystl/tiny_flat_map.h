@@ -0,0 +1,324 @@
+#pragma once
+
+#include "tiny_flat_set.h"
+
+namespace Tiny
+{
+
+// walks the key and value vectors in step; dereferencing yields a pair of
+// references rather than a stored pair
+template <typename Key, typename T, typename Ref, typename Ptr>
+struct __flat_map_iterator
+{
+    using iterator = __flat_map_iterator<Key, T, T&, T*>;
+    using self = __flat_map_iterator<Key, T, Ref, Ptr>;
+
+    using iterator_category = random_access_iterator_tag;
+    using value_type = std::pair<Key, T>;
+    using reference = std::pair<const Key&, Ref>;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    struct pointer {
+        reference ref;
+        const reference* operator->() const { return &ref; }
+    };
+
+    const Key* key;
+    Ptr value;
+
+    __flat_map_iterator() { }
+    __flat_map_iterator(const Key* k, Ptr v) : key(k), value(v) { }
+    __flat_map_iterator(const iterator& x) : key(x.key), value(x.value) { }
+
+    bool operator==(const self& x) const { return key == x.key; }
+    bool operator!=(const self& x) const { return key != x.key; }
+    bool operator<(const self& x) const { return key < x.key; }
+    reference operator*() const { return reference(*key, *value); }
+    pointer operator->() const { return pointer{ **this }; }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    self& operator++() {
+        ++key, ++value;
+        return *this;
+    }
+    self operator++(int) {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    self& operator--() {
+        --key, --value;
+        return *this;
+    }
+    self operator--(int) {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+    self& operator+=(difference_type n) {
+        key += n, value += n;
+        return *this;
+    }
+    self& operator-=(difference_type n) { return *this += -n; }
+    self operator+(difference_type n) const { return self(*this) += n; }
+    self operator-(difference_type n) const { return self(*this) += -n; }
+    difference_type operator-(const self& x) const { return key - x.key; }
+};
+
+// keys and mapped values in two parallel sorted vectors, so a lookup only
+// touches the keys. Same invalidation rules as flat_set
+template <typename Key, typename T, typename Compare, typename Alloc, bool Unique>
+class __flat_map_base
+{
+public:
+    using key_type = Key;
+    using data_type = T;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using key_compare = Compare;
+    using key_container_type = vector<Key, Alloc>;
+    using mapped_container_type = vector<T, Alloc>;
+    using iterator = __flat_map_iterator<Key, T, T&, T*>;
+    using const_iterator = __flat_map_iterator<Key, T, const T&, const T*>;
+    using reference = typename iterator::reference;
+    using const_reference = typename const_iterator::reference;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using self = __flat_map_base<Key, T, Compare, Alloc, Unique>;
+
+protected:
+    key_container_type keys;
+    mapped_container_type values;
+    Compare comp;
+
+    iterator position_of(size_type i) {
+        return iterator(keys.begin() + i, values.begin() + i);
+    }
+    const_iterator position_of(size_type i) const {
+        return const_iterator(keys.begin() + i, values.begin() + i);
+    }
+    size_type index_of(const_iterator position) const { return position.key - keys.begin(); }
+    size_type lower_index(const key_type& k) const {
+        return __flat_lower_bound(keys.begin(), keys.size(), k, comp) - keys.begin();
+    }
+    size_type upper_index(const key_type& k) const {
+        return __flat_upper_bound(keys.begin(), keys.size(), k, comp) - keys.begin();
+    }
+    iterator insert_at(size_type i, const key_type& k, const T& v) {
+        keys.insert(keys.begin() + i, k);
+        try {
+            values.insert(values.begin() + i, v);
+        }
+        catch (...) {
+            keys.erase(keys.begin() + i);
+            throw;
+        }
+        return position_of(i);
+    }
+    void merge_sorted(vector<value_type, Alloc>& buf);
+
+public:
+    __flat_map_base(const Compare& c = Compare()) : comp(c) { }
+    __flat_map_base(const self& x) : keys(x.keys), values(x.values), comp(x.comp) { }
+    __flat_map_base(self&& x) noexcept : keys(std::move(x.keys)), values(std::move(x.values)), comp(x.comp) { }
+    self& operator=(const self& x) {
+        if (this == &x) return *this;
+        self tmp(x);
+        swap(tmp);
+        return *this;
+    }
+    self& operator=(self&& x) noexcept {
+        if (this == &x) return *this;
+        self tmp(std::move(x));
+        swap(tmp);
+        return *this;
+    }
+
+    key_compare key_comp() const { return comp; }
+    iterator begin() { return position_of(0); }
+    iterator end() { return position_of(size()); }
+    const_iterator begin() const { return position_of(0); }
+    const_iterator end() const { return position_of(size()); }
+    bool empty() const { return keys.empty(); }
+    size_type size() const { return keys.size(); }
+    size_type capacity() const { return keys.capacity(); }
+    static size_type max_size() { return size_type(-1) / (sizeof(Key) + sizeof(T)); }
+    void reserve(size_type n) {
+        keys.reserve(n);
+        values.reserve(n);
+    }
+    void swap(self& x) noexcept {
+        keys.swap(x.keys);
+        values.swap(x.values);
+        std::swap(comp, x.comp);
+    }
+    const key_container_type& key_sequence() const { return keys; }
+    const mapped_container_type& mapped_sequence() const { return values; }
+
+    iterator lower_bound(const key_type& k) { return position_of(lower_index(k)); }
+    const_iterator lower_bound(const key_type& k) const { return position_of(lower_index(k)); }
+    iterator upper_bound(const key_type& k) { return position_of(upper_index(k)); }
+    const_iterator upper_bound(const key_type& k) const { return position_of(upper_index(k)); }
+    std::pair<iterator, iterator> equal_range(const key_type& k) {
+        return std::pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const {
+        return std::pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+    iterator find(const key_type& k) {
+        size_type i = lower_index(k);
+        return i == size() or comp(k, keys[i]) ? end() : position_of(i);
+    }
+    const_iterator find(const key_type& k) const {
+        size_type i = lower_index(k);
+        return i == size() or comp(k, keys[i]) ? end() : position_of(i);
+    }
+    size_type count(const key_type& k) const { return upper_index(k) - lower_index(k); }
+
+    iterator erase(const_iterator position) {
+        size_type i = index_of(position);
+        keys.erase(keys.begin() + i);
+        values.erase(values.begin() + i);
+        return position_of(i);
+    }
+    iterator erase(const_iterator first, const_iterator last) {
+        size_type i = index_of(first), j = index_of(last);
+        keys.erase(keys.begin() + i, keys.begin() + j);
+        values.erase(values.begin() + i, values.begin() + j);
+        return position_of(i);
+    }
+    size_type erase(const key_type& k) {
+        size_type i = lower_index(k), j = upper_index(k);
+        erase(position_of(i), position_of(j));
+        return j - i;
+    }
+    void clear() {
+        keys.clear();
+        values.clear();
+    }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        vector<value_type, Alloc> buf(first, last);
+        Compare& c = comp;
+        std::stable_sort(buf.begin(), buf.end(), [&c](const value_type& a, const value_type& b) {
+            return c(a.first, b.first);
+        });
+        if (Unique) {
+            buf.erase(std::unique(buf.begin(), buf.end(), [&c](const value_type& a, const value_type& b) {
+                return !c(a.first, b.first) and !c(b.first, a.first);
+            }), buf.end());
+        }
+        merge_sorted(buf);
+    }
+};
+
+template <typename Key, typename T, typename Compare, typename Alloc, bool Unique>
+void __flat_map_base<Key, T, Compare, Alloc, Unique>::merge_sorted(vector<value_type, Alloc>& buf)
+{
+    if (buf.empty()) return;
+    if (keys.empty() or comp(keys.back(), buf.front().first)) {
+        reserve(size() + buf.size());
+        for (const value_type& x : buf) {
+            keys.push_back(x.first);
+            try {
+                values.push_back(x.second);
+            }
+            catch (...) {
+                keys.pop_back();
+                throw;
+            }
+        }
+        return;
+    }
+
+    self result(comp);
+    result.reserve(size() + buf.size());
+    size_type i = 0;
+    const value_type* j = buf.begin();
+    while (i != size() and j != buf.end())
+    {
+        if (comp(j->first, keys[i])) {
+            result.keys.push_back(j->first);
+            result.values.push_back(j->second);
+            j++;
+        }
+        else if (Unique and !comp(keys[i], j->first)) {
+            j++;
+        }
+        else {
+            result.keys.push_back(keys[i]);
+            result.values.push_back(values[i]);
+            i++;
+        }
+    }
+    for (; i != size(); i++) {
+        result.keys.push_back(keys[i]);
+        result.values.push_back(values[i]);
+    }
+    for (; j != buf.end(); j++) {
+        result.keys.push_back(j->first);
+        result.values.push_back(j->second);
+    }
+    swap(result);
+}
+
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+class flat_map : public __flat_map_base<Key, T, Compare, Alloc, true>
+{
+    using base = __flat_map_base<Key, T, Compare, Alloc, true>;
+public:
+    using typename base::key_type;
+    using typename base::value_type;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using pair_iterator_bool = std::pair<iterator, bool>;
+
+    flat_map() : base(Compare()) { }
+    explicit flat_map(const Compare& comp) : base(comp) { }
+    template <typename InputIterator>
+    flat_map(InputIterator first, InputIterator last, const Compare& comp = Compare())
+        : base(comp) { base::insert(first, last); }
+
+    T& operator[](const key_type& k) {
+        size_t i = base::lower_index(k);
+        if (i == base::size() or base::comp(k, base::keys[i]))
+            base::insert_at(i, k, T());
+        return base::values[i];
+    }
+
+    using base::insert;
+    pair_iterator_bool insert(const value_type& x) {
+        size_t i = base::lower_index(x.first);
+        if (i != base::size() and !base::comp(x.first, base::keys[i]))
+            return pair_iterator_bool(base::position_of(i), false);
+        return pair_iterator_bool(base::insert_at(i, x.first, x.second), true);
+    }
+    // the hint is ignored; the binary search is already cheap
+    iterator insert(const_iterator, const value_type& x) { return insert(x).first; }
+};
+
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+class flat_multimap : public __flat_map_base<Key, T, Compare, Alloc, false>
+{
+    using base = __flat_map_base<Key, T, Compare, Alloc, false>;
+public:
+    using typename base::value_type;
+    using typename base::iterator;
+    using typename base::const_iterator;
+
+    flat_multimap() : base(Compare()) { }
+    explicit flat_multimap(const Compare& comp) : base(comp) { }
+    template <typename InputIterator>
+    flat_multimap(InputIterator first, InputIterator last, const Compare& comp = Compare())
+        : base(comp) { base::insert(first, last); }
+
+    using base::insert;
+    iterator insert(const value_type& x) {
+        return base::insert_at(base::upper_index(x.first), x.first, x.second);
+    }
+    iterator insert(const_iterator, const value_type& x) { return insert(x); }
+};
+
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <iso646.h>
+#include "tiny_vector.h"
+
+namespace Tiny
+{
+
+// binary search whose only branch is the loop itself: the step is picked
+// with a conditional move, so a lookup costs log2(n) predictable iterations
+template <typename T, typename Key, typename Compare>
+const T* __flat_lower_bound(const T* first, size_t n, const Key& k, Compare& comp)
+{
+    if (n == 0) return first;
+    while (n > 1) {
+        size_t half = n / 2;
+        first = comp(first[half], k) ? first + half : first;
+        n -= half;
+    }
+    return first + comp(*first, k);
+}
+
+template <typename T, typename Key, typename Compare>
+const T* __flat_upper_bound(const T* first, size_t n, const Key& k, Compare& comp)
+{
+    if (n == 0) return first;
+    while (n > 1) {
+        size_t half = n / 2;
+        first = !comp(k, first[half]) ? first + half : first;
+        n -= half;
+    }
+    return first + !comp(k, *first);
+}
+
+// keys in one sorted vector; insert and erase are O(n), lookups are binary
+// searches over contiguous memory. Bulk insert sorts the new keys and merges
+// them in once. Iterators are invalidated by every insert and erase
+template <typename Key, typename Compare, typename Alloc, bool Unique>
+class __flat_set_base
+{
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using container_type = vector<Key, Alloc>;
+    using pointer = const value_type*;
+    using const_pointer = const value_type*;
+    using reference = const value_type&;
+    using const_reference = const value_type&;
+    using iterator = const value_type*;
+    using const_iterator = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using self = __flat_set_base<Key, Compare, Alloc, Unique>;
+
+protected:
+    container_type keys;
+    Compare comp;
+
+    iterator position_of(size_type i) const { return keys.begin() + i; }
+    void merge_sorted(container_type& buf);
+
+public:
+    __flat_set_base(const Compare& c = Compare()) : comp(c) { }
+    __flat_set_base(const self& x) : keys(x.keys), comp(x.comp) { }
+    __flat_set_base(self&& x) noexcept : keys(std::move(x.keys)), comp(x.comp) { }
+    self& operator=(const self& x) {
+        keys = x.keys;
+        comp = x.comp;
+        return *this;
+    }
+    self& operator=(self&& x) noexcept {
+        keys = std::move(x.keys);
+        comp = x.comp;
+        return *this;
+    }
+
+    key_compare key_comp() const { return comp; }
+    value_compare value_comp() const { return comp; }
+    iterator begin() const { return keys.begin(); }
+    iterator end() const { return keys.end(); }
+    bool empty() const { return keys.empty(); }
+    size_type size() const { return keys.size(); }
+    size_type capacity() const { return keys.capacity(); }
+    static size_type max_size() { return size_type(-1) / sizeof(Key); }
+    void reserve(size_type n) { keys.reserve(n); }
+    void swap(self& x) noexcept {
+        keys.swap(x.keys);
+        std::swap(comp, x.comp);
+    }
+    const container_type& sequence() const { return keys; }
+
+    iterator lower_bound(const key_type& k) const {
+        return __flat_lower_bound(keys.begin(), keys.size(), k, comp);
+    }
+    iterator upper_bound(const key_type& k) const {
+        return __flat_upper_bound(keys.begin(), keys.size(), k, comp);
+    }
+    std::pair<iterator, iterator> equal_range(const key_type& k) const {
+        return std::pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+    }
+    iterator find(const key_type& k) const {
+        iterator i = lower_bound(k);
+        return i == end() or comp(k, *i) ? end() : i;
+    }
+    size_type count(const key_type& k) const {
+        std::pair<iterator, iterator> r = equal_range(k);
+        return r.second - r.first;
+    }
+
+    iterator erase(iterator position) {
+        size_type i = position - begin();
+        keys.erase(keys.begin() + i);
+        return position_of(i);
+    }
+    iterator erase(iterator first, iterator last) {
+        size_type i = first - begin();
+        keys.erase(keys.begin() + i, keys.begin() + (last - begin()));
+        return position_of(i);
+    }
+    size_type erase(const key_type& k) {
+        std::pair<iterator, iterator> r = equal_range(k);
+        size_type n = r.second - r.first;
+        erase(r.first, r.second);
+        return n;
+    }
+    void clear() { keys.clear(); }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        container_type buf(first, last);
+        std::stable_sort(buf.begin(), buf.end(), comp);
+        if (Unique) {
+            Compare& c = comp;
+            buf.erase(std::unique(buf.begin(), buf.end(), [&c](const Key& a, const Key& b) {
+                return !c(a, b) and !c(b, a);
+            }), buf.end());
+        }
+        merge_sorted(buf);
+    }
+};
+
+// existing keys come first among equals, and win over new ones when Unique
+template <typename Key, typename Compare, typename Alloc, bool Unique>
+void __flat_set_base<Key, Compare, Alloc, Unique>::merge_sorted(container_type& buf)
+{
+    if (buf.empty()) return;
+    if (keys.empty() or comp(keys.back(), buf.front())) {
+        keys.reserve(keys.size() + buf.size());
+        for (const Key& k : buf)
+            keys.push_back(k);
+        return;
+    }
+
+    container_type result;
+    result.reserve(keys.size() + buf.size());
+    const Key* i = keys.begin();
+    const Key* j = buf.begin();
+    while (i != keys.end() and j != buf.end())
+    {
+        if (comp(*j, *i))
+            result.push_back(*j++);
+        else if (Unique and !comp(*i, *j))
+            j++;
+        else
+            result.push_back(*i++);
+    }
+    for (; i != keys.end(); ++i)
+        result.push_back(*i);
+    for (; j != buf.end(); ++j)
+        result.push_back(*j);
+    keys.swap(result);
+}
+
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class flat_set : public __flat_set_base<Key, Compare, Alloc, true>
+{
+    using base = __flat_set_base<Key, Compare, Alloc, true>;
+public:
+    using typename base::value_type;
+    using typename base::iterator;
+    using pair_iterator_bool = std::pair<iterator, bool>;
+
+    flat_set() : base(Compare()) { }
+    explicit flat_set(const Compare& comp) : base(comp) { }
+    template <typename InputIterator>
+    flat_set(InputIterator first, InputIterator last, const Compare& comp = Compare())
+        : base(comp) { base::insert(first, last); }
+
+    using base::insert;
+    pair_iterator_bool insert(const value_type& x) {
+        iterator i = base::lower_bound(x);
+        if (i != base::end() and !base::comp(x, *i))
+            return pair_iterator_bool(i, false);
+        size_t n = i - base::begin();
+        base::keys.insert(base::keys.begin() + n, x);
+        return pair_iterator_bool(base::position_of(n), true);
+    }
+    // the hint is ignored; the binary search is already cheap
+    iterator insert(iterator, const value_type& x) { return insert(x).first; }
+};
+
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class flat_multiset : public __flat_set_base<Key, Compare, Alloc, false>
+{
+    using base = __flat_set_base<Key, Compare, Alloc, false>;
+public:
+    using typename base::value_type;
+    using typename base::iterator;
+
+    flat_multiset() : base(Compare()) { }
+    explicit flat_multiset(const Compare& comp) : base(comp) { }
+    template <typename InputIterator>
+    flat_multiset(InputIterator first, InputIterator last, const Compare& comp = Compare())
+        : base(comp) { base::insert(first, last); }
+
+    using base::insert;
+    iterator insert(const value_type& x) {
+        size_t n = base::upper_bound(x) - base::begin();
+        base::keys.insert(base::keys.begin() + n, x);
+        return base::position_of(n);
+    }
+    iterator insert(iterator, const value_type& x) { return insert(x); }
+};
+
+}
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <string>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 namespace Tiny
 {
 
-size_t __tiny_hash_string(const char* s)
+inline size_t __tiny_hash_string(const char* s)
 {
     unsigned h = 0; 
     for ( ; *s; ++s)
@@ -13,14 +16,33 @@ size_t __tiny_hash_string(const char* s)
     return h;
 }
 
+inline size_t __tiny_hash_string(const char* s, size_t n)
+{
+    unsigned h = 0;
+    for (size_t i = 0; i < n; i++)
+        h = h * 5 + s[i];
+    return h;
+}
+
 template <class Key> struct hash { };
 
+// transparent: a C string or string_view hashes like the equal std::string,
+// so lookups with them need no temporary string
 template <> 
 struct hash<std::string>
 {
+    using is_transparent = void;
     size_t operator()(const std::string& s) const { 
-        return __tiny_hash_string(s.c_str()); 
+        return __tiny_hash_string(s.data(), s.size()); 
+    }
+    size_t operator()(const char* s) const {
+        return __tiny_hash_string(s);
+    }
+#if __cplusplus >= 201703L
+    size_t operator()(std::string_view s) const {
+        return __tiny_hash_string(s.data(), s.size());
     }
+#endif
 };
 
 template <> 
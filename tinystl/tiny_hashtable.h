@@ -1,6 +1,8 @@
 #pragma once
 
 #include "tiny_vector.h"
+#include "tiny_slist.h"
+#include "tiny_node_handle.h"
 #include <algorithm>
 
 namespace Tiny
@@ -21,18 +23,13 @@ const unsigned prime_list[num_primes] = {
 };
 
 template <typename Value>
-struct __hashtable_node
-{
-    using node = __hashtable_node<Value>;
-    node* next;
-    Value val;
-};
+using __hashtable_node = __slist_node<Value>;
 
 template <typename Value, typename Key, typename HashFcn,
         typename ExtractKey, typename EqualKey, typename Alloc>
 struct __hashtable_iterator
 {
-    using hashtable = hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
+    using table = hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
     using node = __hashtable_node<Value>;
     using self = __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 
@@ -44,10 +41,10 @@ struct __hashtable_iterator
     using pointer = Value*;
 
     node* cur;
-    hashtable* ht;
+    table* ht;
 
     __hashtable_iterator() = default;
-    __hashtable_iterator(node* n, hashtable* tab) : cur(n), ht(tab) { }
+    __hashtable_iterator(node* n, table* tab) : cur(n), ht(tab) { }
     reference operator*() const { return cur->val; }
     pointer operator->() const { return &(operator*()); }
     bool operator==(__hashtable_iterator it) const { return cur == it.cur; }
@@ -76,7 +73,7 @@ template <typename Value, typename Key, typename HashFcn,
         typename ExtractKey, typename EqualKey, typename Alloc>
 struct __hashtable_const_iterator
 {
-    using hashtable = hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
+    using table = hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
     using node = __hashtable_node<Value>;
     using iterator = __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
     using self = __hashtable_const_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
@@ -89,11 +86,11 @@ struct __hashtable_const_iterator
     using pointer = const Value*;
 
     const node* cur;
-    const hashtable* ht;
+    const table* ht;
 
     __hashtable_const_iterator() = default;
     __hashtable_const_iterator(iterator it) : cur(it.cur), ht(it.ht) { }
-    __hashtable_const_iterator(const node* n, const hashtable* tab) : cur(n), ht(tab) { }
+    __hashtable_const_iterator(const node* n, const table* tab) : cur(n), ht(tab) { }
     reference operator*() const { return cur->val; }
     pointer operator->() const { return &(operator*()); }
     bool operator==(__hashtable_const_iterator it) const { return cur == it.cur; }
@@ -139,12 +136,17 @@ public:
     friend class __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
     friend class __hashtable_const_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 
+private:
+    using node = __hashtable_node<Value>;
+
+public:
+    using node_type = __node_handle<node, value_type, Alloc>;
+
 private:
     hasher hash;
     key_equal equals;
     ExtractKey get_key;
 
-    using node = __hashtable_node<Value>;
     using node_allocator = simple_alloc<node, Alloc>;
     vector<node*, Alloc> buckets;
     size_type num_elements;
@@ -190,6 +192,16 @@ private:
         destroy(&n->val);
         node_allocator::deallocate(n);
     }
+    // takes p off its bucket chain without freeing it
+    void unlink_node(node* p)
+    {
+        node** link = &buckets[bkt_num(p->val)];
+        while (*link != p)
+            link = &(*link)->next;
+        *link = p->next;
+        p->next = nullptr;
+        num_elements--;
+    }
     void initialize_buckets(size_type n)
     {
         const size_type n_buckets = next_size(n);
@@ -251,19 +263,31 @@ public:
     {
         copy_from(ht);
     }
-    hashtable(hashtable&& ht) 
-        : hash(ht.hash), equals(ht.equals), get_key(ht.get_key)
+    // the source is left with no buckets; it grows them again on insert
+    hashtable(hashtable&& ht) noexcept
+        : hash(ht.hash), equals(ht.equals), get_key(ht.get_key), num_elements(ht.num_elements)
     {
         buckets.swap(ht.buckets);
-        num_elements = ht.num_elements;
-        ht.buckets.resize(0);
+        ht.num_elements = 0;
     }
     ~hashtable() { clear(); }
+    hashtable& operator=(const hashtable& ht) {
+        if (this == &ht) return *this;
+        hashtable tmp(ht);
+        swap(tmp);
+        return *this;
+    }
+    hashtable& operator=(hashtable&& ht) noexcept {
+        if (this == &ht) return *this;
+        hashtable tmp(std::move(ht));
+        swap(tmp);
+        return *this;
+    }
     
     void resize(size_type num_elements_hint);
     auto insert_unique_noresize(const value_type&) -> std::pair<iterator, bool>;
     auto insert_equal_noresize(const value_type&) -> iterator;
-    void swap(hashtable& ht) {
+    void swap(hashtable& ht) noexcept {
         std::swap(hash, ht.hash);
         std::swap(equals, ht.equals);
         std::swap(get_key, ht.get_key);
@@ -278,13 +302,44 @@ public:
         resize(num_elements + 1);
         return insert_equal_noresize(obj);
     }
+    auto insert_unique(node_type&& nh) -> std::pair<iterator, bool>;
+    auto insert_equal(node_type&& nh) -> iterator;
+    node_type extract(const_iterator position) {
+        node* p = const_cast<node*>(position.cur);
+        unlink_node(p);
+        return node_type(p, &p->val);
+    }
+    node_type extract(const key_type& key) {
+        iterator it = find(key);
+        return it == end() ? node_type() : extract(it);
+    }
+    void merge_unique(hashtable& source);
+    void merge_equal(hashtable& source);
     auto erase(const key_type&) -> size_type;
     void erase(iterator);
     void clear();
     void copy_from(const hashtable&);
-    iterator find(const key_type&);
-    const_iterator find(const key_type&) const;
-    size_type count(const key_type&) const;
+    iterator find(const key_type& key) { return iterator(find_node(key), this); }
+    const_iterator find(const key_type& key) const { return const_iterator(find_node(key), this); }
+    size_type count(const key_type& key) const { return count_key(key); }
+
+    // when both the hasher and key_equal declare is_transparent, lookups
+    // take any type they accept, e.g. a const char* for string keys
+    template <typename K, typename H = HashFcn, typename = typename H::is_transparent,
+              typename E = EqualKey, typename = typename E::is_transparent>
+    iterator find(const K& key) { return iterator(find_node(key), this); }
+    template <typename K, typename H = HashFcn, typename = typename H::is_transparent,
+              typename E = EqualKey, typename = typename E::is_transparent>
+    const_iterator find(const K& key) const { return const_iterator(find_node(key), this); }
+    template <typename K, typename H = HashFcn, typename = typename H::is_transparent,
+              typename E = EqualKey, typename = typename E::is_transparent>
+    size_type count(const K& key) const { return count_key(key); }
+
+private:
+    template <typename K>
+    node* find_node(const K& key) const;
+    template <typename K>
+    size_type count_key(const K& key) const;
 };
 
 template <typename Value, typename Key, typename HashFcn, 
@@ -342,10 +397,96 @@ auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::insert_equal_n
     return iterator(tmp, this);
 }
 
+// on failure the handle keeps its node
+template <typename Value, typename Key, typename HashFcn, 
+        typename ExtractKey, typename EqualKey, typename Alloc>
+auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::insert_unique(node_type&& nh) -> std::pair<iterator, bool>
+{
+    if (nh.empty())
+        return { end(), false };
+    resize(num_elements + 1);
+    node* tmp = nh.get();
+    const size_type n = bkt_num(tmp->val);
+    for (node* cur = buckets[n]; cur; cur = cur->next)
+        if (equals(get_key(cur->val), get_key(tmp->val)))
+            return { iterator(cur, this), false };
+    nh.release();
+    tmp->next = buckets[n];
+    buckets[n] = tmp;
+    ++num_elements;
+    return { iterator(tmp, this), true };
+}
+
+template <typename Value, typename Key, typename HashFcn, 
+        typename ExtractKey, typename EqualKey, typename Alloc>
+auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::insert_equal(node_type&& nh) -> iterator
+{
+    if (nh.empty())
+        return end();
+    resize(num_elements + 1);
+    node* tmp = nh.release();
+    const size_type n = bkt_num(tmp->val);
+    tmp->next = buckets[n];
+    buckets[n] = tmp;
+    num_elements++;
+    return iterator(tmp, this);
+}
+
+// relinks the nodes of source whose keys are not here yet; the rest stay
+template <typename Value, typename Key, typename HashFcn, 
+        typename ExtractKey, typename EqualKey, typename Alloc>
+void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::merge_unique(hashtable& source)
+{
+    if (this == &source) return;
+    for (size_type bucket = 0; bucket < source.buckets.size(); bucket++)
+    {
+        node** link = &source.buckets[bucket];
+        while (*link != nullptr)
+        {
+            node* cur = *link;
+            if (find(get_key(cur->val)) != end()) {
+                link = &cur->next;
+                continue;
+            }
+            resize(num_elements + 1);
+            *link = cur->next;
+            source.num_elements--;
+            const size_type n = bkt_num(cur->val);
+            cur->next = buckets[n];
+            buckets[n] = cur;
+            num_elements++;
+        }
+    }
+}
+
+template <typename Value, typename Key, typename HashFcn, 
+        typename ExtractKey, typename EqualKey, typename Alloc>
+void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::merge_equal(hashtable& source)
+{
+    if (this == &source) return;
+    resize(num_elements + source.num_elements);
+    for (size_type bucket = 0; bucket < source.buckets.size(); bucket++)
+    {
+        node* cur = source.buckets[bucket];
+        while (cur != nullptr)
+        {
+            node* next = cur->next;
+            const size_type n = bkt_num(cur->val);
+            cur->next = buckets[n];
+            buckets[n] = cur;
+            cur = next;
+        }
+        source.buckets[bucket] = nullptr;
+    }
+    num_elements += source.num_elements;
+    source.num_elements = 0;
+}
+
 template <typename Value, typename Key, typename HashFcn, 
         typename ExtractKey, typename EqualKey, typename Alloc>
 auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::erase(const key_type& key) -> size_type
 {
+    if (buckets.empty()) return 0;
     const size_type n = bkt_num_key(key);
     node* first = buckets[n];
     size_type erased = 0;
@@ -414,13 +555,15 @@ template <typename Value, typename Key, typename HashFcn,
         typename ExtractKey, typename EqualKey, typename Alloc>
 void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::clear()
 {
-    for (node* cur : buckets)
+    for (node*& first : buckets)
     {
+        node* cur = first;
         while (cur != nullptr) {
             node* next = cur->next;
             delete_node(cur);
             cur = next;
         }
+        first = nullptr;
     }
     num_elements = 0;
 }
@@ -447,6 +590,7 @@ void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::copy_from(cons
                 copy = copy->next;
             }
         }
+        num_elements = ht.num_elements;
     }
     catch (...) {
         clear();
@@ -456,33 +600,25 @@ void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::copy_from(cons
 
 template <typename Value, typename Key, typename HashFcn, 
         typename ExtractKey, typename EqualKey, typename Alloc>
-auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::find(const key_type& key) -> iterator
+template <typename K>
+auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::find_node(const K& key) const -> node*
 {
-    size_type n = bkt_num_key(key);
+    if (buckets.empty()) return nullptr;
+    size_type n = hash(key) % buckets.size();
     node* first;
     for (first = buckets[n]; first; first = first->next)
         if (equals(get_key(first->val), key))
             break;
-    return iterator(first, this);
+    return first;
 }
 
 template <typename Value, typename Key, typename HashFcn, 
         typename ExtractKey, typename EqualKey, typename Alloc>
-auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::find(const key_type& key) const -> const_iterator
+template <typename K>
+auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::count_key(const K& key) const -> size_type
 {
-    size_type n = bkt_num_key(key);
-    node* first;
-    for (first = buckets[n]; first; first = first->next)
-        if (equals(get_key(first->val), key))
-            break;
-    return const_iterator(first, this);
-}
-
-template <typename Value, typename Key, typename HashFcn, 
-        typename ExtractKey, typename EqualKey, typename Alloc>
-auto hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::count(const key_type& key) const -> size_type
-{
-    const size_type n = bkt_num_key(key);
+    if (buckets.empty()) return 0;
+    const size_type n = hash(key) % buckets.size();
     size_type result = 0;
     for (const node* cur = buckets[n]; cur; cur = cur->next)
         if (equals(get_key(cur->val), key))
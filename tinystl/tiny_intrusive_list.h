@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cassert>
+#include <type_traits>
+#include <iso646.h>
+#include "tiny_iterator.h"
+
+namespace Tiny
+{
+
+// prev/next laid out like __list_node; copying an object never copies its links.
+// Debug builds assert that a hook is not linked twice, unlinked twice, or
+// destroyed while still on a list
+struct intrusive_list_hook
+{
+    using hook_pointer = intrusive_list_hook*;
+    hook_pointer prev;
+    hook_pointer next;
+
+    intrusive_list_hook() : prev(nullptr), next(nullptr) { }
+    intrusive_list_hook(const intrusive_list_hook&) : prev(nullptr), next(nullptr) { }
+    intrusive_list_hook& operator=(const intrusive_list_hook&) { return *this; }
+#ifndef NDEBUG
+    ~intrusive_list_hook() { assert(!is_linked() && "intrusive_list_hook destroyed while linked"); }
+#endif
+
+    bool is_linked() const { return next != nullptr; }
+};
+
+template <typename T, intrusive_list_hook T::*Hook>
+struct __intrusive_list_traits
+{
+    using hook_pointer = intrusive_list_hook*;
+
+    static size_t offset() {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        char* base = reinterpret_cast<char*>(&storage);
+        return reinterpret_cast<char*>(&(reinterpret_cast<T*>(base)->*Hook)) - base;
+    }
+    static T* owner(hook_pointer h) {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(h) - offset());
+    }
+    static hook_pointer hook(T& x) { return &(x.*Hook); }
+};
+
+template <typename T, intrusive_list_hook T::*Hook, typename Ref, typename Ptr>
+struct __intrusive_list_iterator
+{
+    using iterator = __intrusive_list_iterator<T, Hook, T&, T*>;
+    using self = __intrusive_list_iterator<T, Hook, Ref, Ptr>;
+    using traits = __intrusive_list_traits<T, Hook>;
+
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = T;
+    using pointer = Ptr;
+    using reference = Ref;
+    using hook_pointer = intrusive_list_hook*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    hook_pointer node;
+
+    __intrusive_list_iterator() { }
+    __intrusive_list_iterator(hook_pointer x) : node(x) { }
+    __intrusive_list_iterator(const iterator& x) : node(x.node) { }
+
+    bool operator==(const self& x) const { return node == x.node; }
+    bool operator!=(const self& x) const { return node != x.node; }
+    reference operator*() const { return *traits::owner(node); }
+    pointer operator->() const { return &operator*(); }
+
+    self& operator++() {
+        node = node->next;
+        return *this;
+    }
+    self operator++(int) {
+        self tmp = *this;
+        node = node->next;
+        return tmp;
+    }
+    self& operator--() {
+        node = node->prev;
+        return *this;
+    }
+    self operator--(int) {
+        self tmp = *this;
+        node = node->prev;
+        return tmp;
+    }
+};
+
+// links existing objects through a hook member; the list never allocates or
+// copies elements, and does not own them
+template <typename T, intrusive_list_hook T::*Hook>
+class intrusive_list
+{
+protected:
+    using traits = __intrusive_list_traits<T, Hook>;
+public:
+    using value_type = T;
+    using pointer = value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = __intrusive_list_iterator<T, Hook, T&, T*>;
+    using const_iterator = __intrusive_list_iterator<T, Hook, const T&, const T*>;
+    using hook_pointer = intrusive_list_hook*;
+
+protected:
+    intrusive_list_hook header;
+    size_type node_count;
+
+    void empty_initialized() {
+        header.next = &header;
+        header.prev = &header;
+        node_count = 0;
+    }
+    static void unlink_hook(hook_pointer p) {
+        p->prev->next = p->next;
+        p->next->prev = p->prev;
+        p->prev = p->next = nullptr;
+    }
+    // relinks [first, last) before position
+    void transfer(iterator position, iterator first, iterator last) {
+        if (position == last) return;
+        last.node->prev->next = position.node;
+        first.node->prev->next = last.node;
+        position.node->prev->next = first.node;
+        hook_pointer tmp = position.node->prev;
+        position.node->prev = last.node->prev;
+        last.node->prev = first.node->prev;
+        first.node->prev = tmp;
+    }
+
+public:
+    iterator begin() { return header.next; }
+    iterator end() { return &header; }
+    const_iterator begin() const { return header.next; }
+    const_iterator end() const { return const_cast<hook_pointer>(&header); }
+    bool empty() const { return header.next == &header; }
+    size_type size() const { return node_count; }
+    reference front() { return *begin(); }
+    reference back() { return *(--end()); }
+    const_reference front() const { return *begin(); }
+    const_reference back() const { return *(--end()); }
+
+    intrusive_list() { empty_initialized(); }
+    intrusive_list(const intrusive_list&) = delete;
+    intrusive_list& operator=(const intrusive_list&) = delete;
+    intrusive_list(intrusive_list&& x) {
+        empty_initialized();
+        splice(end(), x);
+    }
+    ~intrusive_list() {
+        clear();
+        header.prev = header.next = nullptr;
+    }
+
+    static iterator iterator_to(T& x) { return traits::hook(x); }
+    static const_iterator iterator_to(const T& x) { return traits::hook(const_cast<T&>(x)); }
+
+    iterator insert(iterator position, T& x) {
+        hook_pointer tmp = traits::hook(x);
+        assert(!tmp->is_linked() && "intrusive_list: element is already linked");
+        tmp->next = position.node;
+        tmp->prev = position.node->prev;
+        position.node->prev->next = tmp;
+        position.node->prev = tmp;
+        node_count++;
+        return tmp;
+    }
+    void push_front(T& x) { insert(begin(), x); }
+    void push_back(T& x) { insert(end(), x); }
+    iterator erase(iterator position) {
+        assert(position.node != &header && position.node->is_linked());
+        hook_pointer next_node = position.node->next;
+        unlink_hook(position.node);
+        node_count--;
+        return next_node;
+    }
+    // O(1): the element finds its neighbours through its own hook
+    void erase(T& x) { erase(iterator_to(x)); }
+    void pop_front() { erase(begin()); }
+    void pop_back() { erase(--end()); }
+    void swap(intrusive_list&);
+
+    void splice(iterator position, intrusive_list& x);
+    void splice(iterator position, intrusive_list& x, iterator i);
+    void clear();
+};
+
+template <typename T, intrusive_list_hook T::*Hook>
+void intrusive_list<T, Hook>::swap(intrusive_list& x)
+{
+    if (this == &x) return;
+    intrusive_list tmp;
+    tmp.splice(tmp.end(), x);
+    x.splice(x.end(), *this);
+    splice(end(), tmp);
+}
+
+template <typename T, intrusive_list_hook T::*Hook>
+void intrusive_list<T, Hook>::splice(iterator position, intrusive_list& x)
+{
+    if (x.empty() or this == &x) return;
+    transfer(position, x.begin(), x.end());
+    node_count += x.node_count;
+    x.node_count = 0;
+}
+
+template <typename T, intrusive_list_hook T::*Hook>
+void intrusive_list<T, Hook>::splice(iterator position, intrusive_list& x, iterator i)
+{
+    iterator j = i;
+    ++j;
+    if (position == i or position == j) return;
+    transfer(position, i, j);
+    node_count++;
+    x.node_count--;
+}
+
+template <typename T, intrusive_list_hook T::*Hook>
+void intrusive_list<T, Hook>::clear()
+{
+    hook_pointer cur = header.next;
+    while (cur != &header) {
+        hook_pointer next = cur->next;
+        cur->prev = cur->next = nullptr;
+        cur = next;
+    }
+    empty_initialized();
+}
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>   // for ptrdiff_t
+
 namespace Tiny
 {
 
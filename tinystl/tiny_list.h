@@ -3,10 +3,16 @@
 // waiting for swap()
 
 #include <algorithm>
+#include <functional>
+#include <exception>
+#include <type_traits>
 #include <iso646.h>
 #include "tiny_construct.h"
 #include "tiny_alloc.h"
 #include "tiny_iterator.h"
+#include "tiny_chain.h"
+#include "tiny_sync.h"
+#include "tiny_vector.h"
 
 namespace Tiny
 {
@@ -26,7 +32,7 @@ struct __list_iterator
     using iterator = __list_iterator<T, T&, T*>;
     using self = __list_iterator<T, Ref, Ptr>;
 
-    using iterator_category = bidirection_iterator_tag;
+    using iterator_category = bidirectional_iterator_tag;
     using value_type = T;
     using pointer = Ptr;
     using reference = Ref;
@@ -84,6 +90,7 @@ public:
 
 protected:
     link_type node;
+    size_type node_count;
     link_type get_node() { return list_node_allocator::allocate(); }
     void put_node(link_type p) { list_node_allocator::deallocate(p); }
     link_type create_node(const T& x) {
@@ -99,7 +106,45 @@ protected:
         node = get_node();
         node->next = node;
         node->prev = node;
+        node_count = 0;
     }
+    // bulk operations take raw nodes from the allocator up to chain_batch at a
+    // time, build a detached chain and link it in with four pointer writes
+    static const size_type chain_batch = 64;
+    link_type take_node(link_type& spare, size_type want) {
+        if (spare == nullptr)
+            spare = list_node_allocator::allocate_chain(int(want < chain_batch ? want : chain_batch));
+        link_type p = spare;
+        spare = list_node_allocator::chain_next(p);
+        return p;
+    }
+    void put_chain(link_type spare) {
+        while (spare != nullptr) {
+            link_type next = list_node_allocator::chain_next(spare);
+            put_node(spare);
+            spare = next;
+        }
+    }
+    void destroy_chain(link_type head, size_type n) {
+        for (; n > 0; n--) {
+            link_type next = head->next;
+            destroy_node(head);
+            head = next;
+        }
+    }
+    template <typename InputIterator>
+    size_type build_chain(InputIterator first, InputIterator last, link_type& head, link_type& tail);
+    size_type fill_chain(size_type n, const T& x, link_type& head, link_type& tail);
+    iterator link_chain(iterator position, link_type head, link_type tail, size_type n) {
+        if (n == 0) return position;
+        head->prev = position.node->prev;
+        position.node->prev->next = head;
+        tail->next = position.node;
+        position.node->prev = tail;
+        node_count += n;
+        return head;
+    }
+    // relinks [first, last) before position; callers keep node_count up to date
     void transfer(iterator position, iterator first, iterator last) {
         if (position == last) return;
         last.node->prev->next = position.node;
@@ -117,31 +162,49 @@ public:
     const_iterator begin() const { return node->next; }
     const_iterator end() const { return node; }
     bool empty() const { return node->next == node; }
-    size_type size() const {
-        size_type result = distance(begin(), end());
-        return result;
-    }
+    size_type size() const { return node_count; }
     reference front() { return *begin(); }
     reference back() { return *(--end()); }
     const_reference front() const { return *begin(); }
     const_reference back() const { return *(--end()); }
 
     list() { empty_initialized(); }
-    ~list() { clear(), destroy_node(node); }
+    ~list() { clear(), put_node(node); }
     list(const list&);
     list(list&&);
-    template <typename InputIterator>
+    template <typename InputIterator, typename = typename
+              std::enable_if<!std::is_integral<InputIterator>::value>::type>
     list(InputIterator first, InputIterator last);
     list& operator=(const list&);
 
+    template <typename InputIterator, typename = typename
+              std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    void assign(InputIterator first, InputIterator last);
+    void assign(size_type n, const T& x);
+    void resize(size_type new_size, const T& x);
+    void resize(size_type new_size) { resize(new_size, T()); }
+
     iterator insert(iterator position, const T& x) {
         link_type tmp = create_node(x);
         tmp->next = position.node;
         tmp->prev = position.node->prev;
         position.node->prev->next = tmp;
         position.node->prev = tmp;
+        node_count++;
         return tmp;
     }
+    template <typename InputIterator, typename = typename
+              std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    iterator insert(iterator position, InputIterator first, InputIterator last) {
+        link_type head, tail;
+        size_type n = build_chain(first, last, head, tail);
+        return link_chain(position, head, tail, n);
+    }
+    iterator insert(iterator position, size_type n, const T& x) {
+        link_type head, tail;
+        n = fill_chain(n, x, head, tail);
+        return link_chain(position, head, tail, n);
+    }
     void push_front(const T& x) { insert(begin(), x); }
     void push_back(const T& x) { insert(end(), x); }
     iterator erase(iterator position) {
@@ -150,8 +213,14 @@ public:
         prev_node->next = next_node;
         next_node->prev = prev_node;
         destroy_node(position.node);
+        node_count--;
         return next_node;
     }
+    iterator erase(iterator first, iterator last) {
+        while (first != last)
+            first = erase(first);
+        return last;
+    }
     void pop_front() { erase(begin()); }
     void pop_back() { erase(--end()); }
     void swap(list&);
@@ -159,20 +228,77 @@ public:
     void splice(iterator position, list&);
     void splice(iterator position, list&, iterator i);
     void splice(iterator position, list&, iterator first, iterator last);
+    void splice(iterator position, list&, iterator first, iterator last, size_type n);
     void clear();
     void remove(const T& value);
     void unique();
     void merge(list&);
+    template <typename Compare>
+    void merge(list&, Compare comp);
     void reverse();
     void sort();
+    template <typename Compare>
+    void sort(Compare comp);
+    void parallel_sort();
+    template <typename Compare>
+    void parallel_sort(Compare comp);
+
+    static const size_type parallel_sort_threshold = 1 << 16;
+
+protected:
+    template <typename Compare>
+    static void merge_chain(link_type& a, link_type b, Compare& comp) {
+        __merge_chain(a, b, &list_node::data, comp);
+    }
+    template <typename Compare>
+    static void sort_chain(link_type& head, Compare& comp) {
+        __sort_chain(head, &list_node::data, comp);
+    }
+    // one piece of parallel_sort, run on the task pool
+    template <typename Compare>
+    struct sort_piece : __pool_task {
+        link_type head;
+        link_type other;
+        Compare comp;
+        std::exception_ptr error;
+
+        explicit sort_piece(const Compare& c) : head(nullptr), other(nullptr), comp(c) { run = &sort; }
+        static void sort(__pool_task* p) {
+            sort_piece* self = static_cast<sort_piece*>(p);
+            try {
+                sort_chain(self->head, self->comp);
+            }
+            catch (...) {
+                self->error = std::current_exception();
+            }
+        }
+        static void merge(__pool_task* p) {
+            sort_piece* self = static_cast<sort_piece*>(p);
+            link_type b = self->other;
+            self->other = nullptr;
+            try {
+                merge_chain(self->head, b, self->comp);
+            }
+            catch (...) {
+                self->error = std::current_exception();
+            }
+        }
+    };
+    link_type detach_chain();
+    void attach_chain(link_type head);
 };
 
 template <typename T, typename Alloc>
 list<T, Alloc>::list(const list& x)
 {
     empty_initialized();
-    for (const T& item : x)
-        push_back(x);
+    try {
+        insert(end(), x.begin(), x.end());
+    }
+    catch (...) {
+        put_node(node);
+        throw;
+    }
 }
 
 template <typename T, typename Alloc>
@@ -183,27 +309,147 @@ list<T, Alloc>::list(list&& x)
 }
 
 template <typename T, typename Alloc>
-template <typename InputIterator>
+template <typename InputIterator, typename>
 list<T, Alloc>::list(InputIterator first, InputIterator last)
 {
     empty_initialized();
-    for (; first != last; first++)
-        push_back(*first);
+    try {
+        insert(end(), first, last);
+    }
+    catch (...) {
+        put_node(node);
+        throw;
+    }
 }
 
 template <typename T, typename Alloc>
 list<T, Alloc>& list<T, Alloc>::operator=(const list& x)
 {
-    clear();
-    for (const T& item : x)
-        push_back(x);
+    if (this != &x)
+        assign(x.begin(), x.end());
     return *this;
 }
 
+// on failure every node built so far is destroyed and the list is untouched
+template <typename T, typename Alloc>
+template <typename InputIterator>
+auto list<T, Alloc>::build_chain(InputIterator first, InputIterator last,
+                                 link_type& head, link_type& tail) -> size_type
+{
+    link_type spare = nullptr;
+    size_type n = 0;
+    head = tail = nullptr;
+    try {
+        for (; first != last; ++first) {
+            // unknown length: batches grow with the number of nodes built
+            link_type p = take_node(spare, std::max(n, size_type(8)));
+            try {
+                construct(&p->data, *first);
+            }
+            catch (...) {
+                put_node(p);
+                throw;
+            }
+            if (n++ == 0)
+                head = p;
+            else
+                tail->next = p;
+            p->prev = tail;
+            tail = p;
+        }
+    }
+    catch (...) {
+        destroy_chain(head, n);
+        put_chain(spare);
+        throw;
+    }
+    put_chain(spare);
+    return n;
+}
+
+template <typename T, typename Alloc>
+auto list<T, Alloc>::fill_chain(size_type n, const T& x, link_type& head, link_type& tail) -> size_type
+{
+    link_type spare = nullptr;
+    size_type built = 0;
+    head = tail = nullptr;
+    try {
+        while (built < n) {
+            link_type p = take_node(spare, n - built);
+            try {
+                construct(&p->data, x);
+            }
+            catch (...) {
+                put_node(p);
+                throw;
+            }
+            if (built++ == 0)
+                head = p;
+            else
+                tail->next = p;
+            p->prev = tail;
+            tail = p;
+        }
+    }
+    catch (...) {
+        destroy_chain(head, built);
+        put_chain(spare);
+        throw;
+    }
+    put_chain(spare);
+    return n;
+}
+
+// existing nodes are reused by assignment; only the surplus is built or freed
+template <typename T, typename Alloc>
+template <typename InputIterator, typename>
+void list<T, Alloc>::assign(InputIterator first, InputIterator last)
+{
+    iterator cur = begin();
+    for (; first != last and cur != end(); ++first, ++cur)
+        *cur = *first;
+    if (first == last)
+        erase(cur, end());
+    else
+        insert(end(), first, last);
+}
+
+template <typename T, typename Alloc>
+void list<T, Alloc>::assign(size_type n, const T& x)
+{
+    iterator cur = begin();
+    for (; n > 0 and cur != end(); --n, ++cur)
+        *cur = x;
+    if (n == 0)
+        erase(cur, end());
+    else
+        insert(end(), n, x);
+}
+
+template <typename T, typename Alloc>
+void list<T, Alloc>::resize(size_type new_size, const T& x)
+{
+    if (new_size >= node_count) {
+        insert(end(), new_size - node_count, x);
+        return;
+    }
+    iterator cur;
+    if (new_size < node_count / 2) {
+        cur = begin();
+        for (size_type i = 0; i < new_size; i++) ++cur;
+    }
+    else {
+        cur = end();
+        for (size_type i = node_count; i > new_size; i--) --cur;
+    }
+    erase(cur, end());
+}
+
 template <typename T, typename Alloc>
 void list<T, Alloc>::swap(list& x)
 {
     std::swap(node, x.node);
+    std::swap(node_count, x.node_count);
 }
 
 template <typename T, typename Alloc>
@@ -217,6 +463,7 @@ void list<T, Alloc>::clear()
     }
     node->next = node;
     node->prev = node;
+    node_count = 0;
 }
 
 template <typename T, typename Alloc>
@@ -254,45 +501,75 @@ void list<T, Alloc>::splice(iterator position, list& x)
 {
     if (x.empty()) return;
     transfer(position, x.begin(), x.end());
+    node_count += x.node_count;
+    x.node_count = 0;
 }
 
 
 template <typename T, typename Alloc>
-void list<T, Alloc>::splice(iterator position, list&, iterator i)
+void list<T, Alloc>::splice(iterator position, list& x, iterator i)
 {
     iterator j = i;
     j++;
     if (position == i or position == j)
         return;
     transfer(position, i, j);
+    if (&x == this) return;
+    node_count++;
+    x.node_count--;
 }
 
 template <typename T, typename Alloc>
-void list<T, Alloc>::splice(iterator position, list&, iterator first, iterator last)
+void list<T, Alloc>::splice(iterator position, list& x, iterator first, iterator last)
+{
+    if (first == last) return;
+    if (&x == this) {
+        transfer(position, first, last);
+        return;
+    }
+    splice(position, x, first, last, distance(first, last));
+}
+
+template <typename T, typename Alloc>
+void list<T, Alloc>::splice(iterator position, list& x, iterator first, iterator last, size_type n)
 {
     if (first == last) return;
     transfer(position, first, last);
+    if (&x == this) return;
+    node_count += n;
+    x.node_count -= n;
 }
 
 template <typename T, typename Alloc>
 void list<T, Alloc>::merge(list& x)
 {
+    merge(x, std::less<T>());
+}
+
+template <typename T, typename Alloc>
+template <typename Compare>
+void list<T, Alloc>::merge(list& x, Compare comp)
+{
+    if (&x == this) return;
     iterator first1 = begin();
     iterator last1 = end();
     iterator first2 = x.begin();
     iterator last2 = x.end();
     while (first1 != last1 and first2 != last2)
     {
-        if (*first1 <= *first2) {
+        if (!comp(*first2, *first1)) {
             first1++;
             continue;
         }
         iterator next = first2;
-        transfer(first1, first2, ++next);
+        for (++next; next != last2 and comp(*next, *first1); ++next) { }
+        transfer(first1, first2, next);
         first2 = next;
     }
     if (first2 != last2)
         transfer(last1, first2, last2);
+    node_count += x.node_count;
+    x.node_count = 0;
 }
 
 template <typename T, typename Alloc>
@@ -307,30 +584,124 @@ void list<T, Alloc>::reverse()
     }
 }
 
+// sort() works on the elements as a null-terminated chain linked through next
+// and restores the prev links in one pass at the end
+
+template <typename T, typename Alloc>
+auto list<T, Alloc>::detach_chain() -> link_type
+{
+    link_type head = node->next;
+    node->prev->next = nullptr;
+    return head;
+}
+
+template <typename T, typename Alloc>
+void list<T, Alloc>::attach_chain(link_type head)
+{
+    link_type prev = node;
+    for (link_type cur = head; cur != nullptr; cur = cur->next) {
+        cur->prev = prev;
+        prev->next = cur;
+        prev = cur;
+    }
+    prev->next = node;
+    node->prev = prev;
+}
+
 template <typename T, typename Alloc>
 void list<T, Alloc>::sort()
 {
-    if (node->next == node->prev) return;
-    list<T, Alloc> carry;
-    list<T, Alloc> counter[64];
-    int fill = 0;
-    while (!empty())
+    sort(std::less<T>());
+}
+
+template <typename T, typename Alloc>
+template <typename Compare>
+void list<T, Alloc>::sort(Compare comp)
+{
+    if (node_count < 2) return;
+    link_type head = detach_chain();
+    try {
+        sort_chain(head, comp);
+    }
+    catch (...) {
+        attach_chain(head);
+        throw;
+    }
+    attach_chain(head);
+}
+
+template <typename T, typename Alloc>
+void list<T, Alloc>::parallel_sort()
+{
+    parallel_sort(std::less<T>());
+}
+
+// splits the chain into one piece per worker of the task pool, sorts the
+// pieces concurrently and merges neighbouring pieces pairwise, which keeps it
+// stable. If comp throws, the list keeps every element in an unspecified order
+
+template <typename T, typename Alloc>
+template <typename Compare>
+void list<T, Alloc>::parallel_sort(Compare comp)
+{
+    __task_pool& pool = __global_task_pool();
+    size_type pieces = pool.size() + 1;
+    if (node_count < parallel_sort_threshold or pieces < 2) {
+        sort(comp);
+        return;
+    }
+    pieces = std::min<size_type>(pieces, node_count / (parallel_sort_threshold / 2));
+
+    vector<sort_piece<Compare>> parts(pieces, sort_piece<Compare>(comp));
+    link_type cur = detach_chain();
+    for (size_type i = 0; i < pieces; i++)
     {
-        carry.splice(carry.begin(), *this, begin());
-        int i;
-        for (i = 0; i < fill; i++)
-        {
-            if (counter[i].empty()) break;
-            counter[i].merge(carry);
-            carry.swap(counter[i]);
+        parts[i].head = cur;
+        size_type len = node_count / pieces + (i < node_count % pieces);
+        for (size_type j = 1; j < len; j++)
+            cur = cur->next;
+        link_type next = cur->next;
+        cur->next = nullptr;
+        cur = next;
+    }
+
+    std::exception_ptr error;
+    for (size_type i = 1; i < pieces; i++)
+        pool.submit(&parts[i]);
+    sort_piece<Compare>::sort(&parts[0]);
+    for (size_type i = 1; i < pieces; i++) {
+        pool.wait(&parts[i]);
+        if (!error) error = parts[i].error;
+    }
+    if (!error) error = parts[0].error;
+
+    for (size_type step = 1; step < pieces and !error; step *= 2)
+    {
+        for (size_type i = 0; i + step < pieces; i += 2 * step) {
+            parts[i].run = &sort_piece<Compare>::merge;
+            parts[i].other = parts[i + step].head;
+            parts[i + step].head = nullptr;
+        }
+        for (size_type i = 2 * step; i + step < pieces; i += 2 * step)
+            pool.submit(&parts[i]);
+        sort_piece<Compare>::merge(&parts[0]);
+        for (size_type i = 2 * step; i + step < pieces; i += 2 * step) {
+            pool.wait(&parts[i]);
+            if (!error) error = parts[i].error;
         }
-        carry.swap(counter[i - 1]);
-        if (i == fill) fill++;
+        if (!error) error = parts[0].error;
     }
 
-    for (int i = 1; i < fill; i++)
-        counter[i].merge(counter[i - 1]);
-    swap(counter[fill - 1]);
+    link_type head = nullptr;
+    for (size_type i = pieces; i-- > 0; )
+        if (head == nullptr)
+            head = parts[i].head;
+        else if (parts[i].head != nullptr) {
+            __append_chain(parts[i].head, head);
+            head = parts[i].head;
+        }
+    attach_chain(head);
+    if (error) std::rethrow_exception(error);
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include "tiny_alloc.h"
+#include "tiny_construct.h"
+#include "tiny_circular_buffer.h"   // for __cb_capacity()
+#include "tiny_sync.h"
+
+namespace Tiny
+{
+
+// bounded multi-producer, multi-consumer queue after Dmitry Vyukov: a cell whose
+// seq equals pos is free for the producer of pos, seq == pos + 1 holds its value
+
+template <typename T>
+struct __mpmc_cell
+{
+    std::atomic<size_t> seq;
+    T data;
+};
+
+template <typename T, typename Alloc = malloc_alloc>
+class mpmc_queue
+{
+public:
+    using value_type = T;
+    using pointer = value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+protected:
+    using cell = __mpmc_cell<T>;
+    using cell_allocator = simple_alloc<cell, Alloc>;
+
+    alignas(__cache_line_size) cell* buf;
+    size_type mask;
+    alignas(__cache_line_size) std::atomic<size_type> enqueue_pos;
+    std::atomic<unsigned> producer_waiters;
+    alignas(__cache_line_size) std::atomic<size_type> dequeue_pos;
+    std::atomic<unsigned> consumer_waiters;
+
+    size_type claim_push(size_type n, size_type& pos);
+    size_type claim_pop(size_type n, size_type& pos);
+
+public:
+    explicit mpmc_queue(size_type n)
+        : enqueue_pos(0), producer_waiters(0), dequeue_pos(0), consumer_waiters(0)
+    {
+        buf = cell_allocator::allocate(__cb_capacity(n));
+        mask = __cb_capacity(n) - 1;
+        for (size_type i = 0; i <= mask; i++)
+            construct(&buf[i].seq, i);
+    }
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+    ~mpmc_queue() {
+        size_type last = enqueue_pos.load(std::memory_order_acquire);
+        for (size_type pos = dequeue_pos.load(std::memory_order_relaxed); pos != last; pos++)
+            destroy(&buf[pos & mask].data);
+        for (size_type i = 0; i <= mask; i++)
+            destroy(&buf[i].seq);
+        cell_allocator::deallocate(buf, mask + 1);
+    }
+
+    size_type capacity() const { return mask + 1; }
+    size_type size() const {
+        size_type deq = dequeue_pos.load(std::memory_order_acquire);
+        size_type enq = enqueue_pos.load(std::memory_order_acquire);
+        return difference_type(enq - deq) > 0 ? enq - deq : 0;
+    }
+    bool empty() const { return size() == 0; }
+
+    bool try_push(const T&);
+    bool try_pop(T&);
+    template <typename InputIterator>
+    size_type try_push_n(InputIterator first, size_type n);
+    template <typename OutputIterator>
+    size_type try_pop_n(OutputIterator result, size_type n);
+    void push(const T&);
+    void pop(T&);
+};
+
+template <typename T, typename Alloc>
+auto mpmc_queue<T, Alloc>::claim_push(size_type n, size_type& pos) -> size_type
+{
+    pos = enqueue_pos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        size_type k = 0;
+        while (k < n and buf[(pos + k) & mask].seq.load(std::memory_order_acquire) == pos + k)
+            k++;
+        if (k == 0) {
+            size_type seq = buf[pos & mask].seq.load(std::memory_order_acquire);
+            if (difference_type(seq - pos) < 0)
+                return 0;
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (enqueue_pos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+            return k;
+    }
+}
+
+template <typename T, typename Alloc>
+auto mpmc_queue<T, Alloc>::claim_pop(size_type n, size_type& pos) -> size_type
+{
+    pos = dequeue_pos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        size_type k = 0;
+        while (k < n and buf[(pos + k) & mask].seq.load(std::memory_order_acquire) == pos + k + 1)
+            k++;
+        if (k == 0) {
+            size_type seq = buf[pos & mask].seq.load(std::memory_order_acquire);
+            if (difference_type(seq - (pos + 1)) < 0)
+                return 0;
+            pos = dequeue_pos.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (dequeue_pos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+            return k;
+    }
+}
+
+template <typename T, typename Alloc>
+bool mpmc_queue<T, Alloc>::try_push(const T& x)
+{
+    size_type pos;
+    if (claim_push(1, pos) == 0) return false;
+    cell& c = buf[pos & mask];
+    construct(&c.data, x);
+    c.seq.store(pos + 1, std::memory_order_release);
+    __atomic_notify_all(c.seq, consumer_waiters);
+    return true;
+}
+
+template <typename T, typename Alloc>
+bool mpmc_queue<T, Alloc>::try_pop(T& x)
+{
+    size_type pos;
+    if (claim_pop(1, pos) == 0) return false;
+    cell& c = buf[pos & mask];
+    x = std::move(c.data);
+    destroy(&c.data);
+    c.seq.store(pos + mask + 1, std::memory_order_release);
+    __atomic_notify_all(c.seq, producer_waiters);
+    return true;
+}
+
+template <typename T, typename Alloc>
+template <typename InputIterator>
+auto mpmc_queue<T, Alloc>::try_push_n(InputIterator first, size_type n) -> size_type
+{
+    size_type pos;
+    n = claim_push(n, pos);
+    for (size_type i = 0; i < n; i++, first++) {
+        cell& c = buf[(pos + i) & mask];
+        construct(&c.data, *first);
+        c.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    for (size_type i = 0; i < n; i++)
+        __atomic_notify_all(buf[(pos + i) & mask].seq, consumer_waiters);
+    return n;
+}
+
+template <typename T, typename Alloc>
+template <typename OutputIterator>
+auto mpmc_queue<T, Alloc>::try_pop_n(OutputIterator result, size_type n) -> size_type
+{
+    size_type pos;
+    n = claim_pop(n, pos);
+    for (size_type i = 0; i < n; i++, result++) {
+        cell& c = buf[(pos + i) & mask];
+        *result = std::move(c.data);
+        destroy(&c.data);
+        c.seq.store(pos + i + mask + 1, std::memory_order_release);
+    }
+    for (size_type i = 0; i < n; i++)
+        __atomic_notify_all(buf[(pos + i) & mask].seq, producer_waiters);
+    return n;
+}
+
+template <typename T, typename Alloc>
+void mpmc_queue<T, Alloc>::push(const T& x)
+{
+    unsigned spins = 0;
+    while (!try_push(x)) {
+        size_type pos = enqueue_pos.load(std::memory_order_relaxed);
+        cell& c = buf[pos & mask];
+        size_type seq = c.seq.load(std::memory_order_acquire);
+        if (difference_type(seq - pos) < 0)
+            __atomic_wait(c.seq, seq, producer_waiters, spins);
+    }
+}
+
+template <typename T, typename Alloc>
+void mpmc_queue<T, Alloc>::pop(T& x)
+{
+    unsigned spins = 0;
+    while (!try_pop(x)) {
+        size_type pos = dequeue_pos.load(std::memory_order_relaxed);
+        cell& c = buf[pos & mask];
+        size_type seq = c.seq.load(std::memory_order_acquire);
+        if (difference_type(seq - (pos + 1)) < 0)
+            __atomic_wait(c.seq, seq, consumer_waiters, spins);
+    }
+}
+
+}
@@ -8,7 +8,8 @@
 namespace Tiny
 {
 
-template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc>
+template <typename Key, typename T, typename Compare = std::less<Key>, typename Alloc = alloc,
+          typename NodeBase = __rb_tree_node_base>
 class multimap
 {
 public:
@@ -17,11 +18,11 @@ public:
     using mapped_type = T;
     using value_type = std::pair<const Key, T>;
     using key_compare = Compare;
-    using self = multimap<Key, T, Compare, Alloc>;
+    using self = multimap<Key, T, Compare, Alloc, NodeBase>;
 
     class value_compare : public std::binary_function<value_type, value_type, bool>
     {
-        friend class multimap<Key, T, Compare, Alloc>;
+        friend class multimap<Key, T, Compare, Alloc, NodeBase>;
     protected:
         Compare comp;
         value_compare(Compare c) : comp(c) { }
@@ -32,7 +33,7 @@ public:
     };
 
 private:
-    using rep_type = rb_tree<key_type, value_type, std::_Select1st<value_type>, key_compare, Alloc>;
+    using rep_type = rb_tree<key_type, value_type, std::_Select1st<value_type>, key_compare, Alloc, NodeBase>;
     rep_type t;
 
 public:
@@ -47,9 +48,15 @@ public:
 
     multimap() : t(Compare()) { }
     explicit multimap(const Compare& comp) : t(comp) { }
+    template <typename InputIterator>
+    multimap(InputIterator first, InputIterator last) : t(Compare()) { t.insert_equal(first, last); }
+    template <typename InputIterator>
+    multimap(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_equal(first, last); }
     multimap(const self& x) : t(x.t) { }
-    multimap(self&& x) : t(x.t) { }
+    multimap(self&& x) noexcept : t(std::move(x.t)) { }
     self& operator=(const self& x) { t = x.t; return *this; }
+    self& operator=(self&& x) noexcept { t = std::move(x.t); return *this; }
 
     key_compare key_comp() const { return t.key_comp(); }
     value_compare value_comp() const { return value_compare(t.key_comp()); }
@@ -60,22 +67,49 @@ public:
     bool empty() const { return t.empty(); }
     size_type size() const { return t.size(); }
     static size_type max_size() { return rep_type::max_size(); }
-    void swap(self& x) { t.swap(x.t); }
+    void swap(self& x) noexcept { t.swap(x.t); }
     
     iterator insert(const value_type& x) {
         return t.insert_equal(x);
     }
+    iterator insert(iterator position, const value_type& x) {
+        return t.insert_equal(position, x);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_equal(first, last);
+    }
     void erase(iterator position) {
         t.erase(position);
     }
-    size_type erase(const value_type& x) {
-        t.erase(x);
+    using node_type = typename rep_type::node_type;
+    node_type extract(iterator position) { return t.extract(position); }
+    node_type extract(const key_type& x) { return t.extract(x); }
+    iterator insert(node_type&& nh) { return t.insert_equal(std::move(nh)); }
+    void merge(self& source) { t.merge_equal(source.t); }
+
+    // O(log n) relinking; see rb_tree::split() and rb_tree::join()
+    void split(const key_type& k, self& right) { t.split(k, right.t); }
+    void join(self& right) { t.join(right.t); }
+    size_type erase(const key_type& x) {
+        return t.erase(x);
     }
     void clear() { t.clear(); }
 
     iterator find(const key_type& x) { return t.find(x); }
     const_iterator find(const key_type& x) const { return t.find(x); }
+    template <typename ForwardIterator, typename OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out) {
+        return t.find_many(first, last, out);
+    }
+    template <typename ForwardIterator, typename OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        return t.find_many(first, last, out);
+    }
     size_type count(const key_type& x) const { return t.count(x); }
+    iterator select(size_type k) { return t.select(k); }
+    const_iterator select(size_type k) const { return t.select(k); }
+    size_type rank(const key_type& x) const { return t.rank(x); }
     iterator lower_bound(const key_type& x) { 
         return t.lower_bound(x); 
     }
@@ -88,6 +122,31 @@ public:
     const_iterator upper_bound(const key_type& x) const { 
         return t.upper_bound(x); 
     }
+    std::pair<iterator, iterator> equal_range(const key_type& x) {
+        return t.equal_range(x);
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& x) const {
+        return t.equal_range(x);
+    }
+
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& x) { return t.find(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator find(const K& x) const { return t.find(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    size_type count(const K& x) const { return t.count(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator lower_bound(const K& x) { return t.lower_bound(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator lower_bound(const K& x) const { return t.lower_bound(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator upper_bound(const K& x) { return t.upper_bound(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator upper_bound(const K& x) const { return t.upper_bound(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    std::pair<iterator, iterator> equal_range(const K& x) { return t.equal_range(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    std::pair<const_iterator, const_iterator> equal_range(const K& x) const { return t.equal_range(x); }
 };
 
 }
\ No newline at end of file
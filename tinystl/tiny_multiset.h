@@ -8,7 +8,8 @@
 namespace Tiny
 {
 
-template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+template <typename Key, typename Compare = std::less<Key>, typename Alloc = alloc,
+          typename NodeBase = __rb_tree_node_base>
 class multiset
 {
 public:
@@ -16,10 +17,10 @@ public:
     using value_type = Key;
     using key_compare = Compare;
     using value_compare = Compare;
-    using self = multiset<Key, Compare, Alloc>;
+    using self = multiset<Key, Compare, Alloc, NodeBase>;
 
 private:
-    using rep_type = rb_tree<key_type, value_type, identity<value_type>, key_compare, Alloc>;
+    using rep_type = rb_tree<key_type, value_type, identity<value_type>, key_compare, Alloc, NodeBase>;
     rep_type t;
 
 public:
@@ -33,10 +34,16 @@ public:
     using difference_type = typename rep_type::difference_type;    
     multiset() : t(Compare()) { }
     explicit multiset(const Compare& comp) : t(comp) { }
+    template <typename InputIterator>
+    multiset(InputIterator first, InputIterator last) : t(Compare()) { t.insert_equal(first, last); }
+    template <typename InputIterator>
+    multiset(InputIterator first, InputIterator last, const Compare& comp)
+        : t(comp) { t.insert_equal(first, last); }
     multiset(const self& x) : t(x.t) { }
-    multiset(self&& x) : t(x.t) { }
+    multiset(self&& x) noexcept : t(std::move(x.t)) { }
 
     self& operator=(const self& x)  { t = x.t; return *this; }
+    self& operator=(self&& x) noexcept { t = std::move(x.t); return *this; }
     key_compare key_comp() const { return t.key_comp(); }
     value_compare value_comp() const { return t.key_comp(); }
     iterator begin() const { return t.begin(); }
@@ -44,27 +51,68 @@ public:
     bool empty() const { return t.empty(); }
     size_type size() const { return t.size(); }
     static size_type max_size() { return rep_type::max_size(); }
-    void swap(self& x) { t.swap(x.t); }
+    void swap(self& x) noexcept { t.swap(x.t); }
 
     iterator insert(const value_type& x) {
         return t.insert_equal(x);
     }
+    iterator insert(iterator position, const value_type& x) {
+        using rep_iterator = typename rep_type::iterator;
+        return t.insert_equal(rep_iterator((typename rep_type::link_type)position.node), x);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_equal(first, last);
+    }
     void erase(iterator position) {
-        t.erase(position);
+        using rep_iterator = typename rep_type::iterator;
+        t.erase(rep_iterator((typename rep_type::link_type)position.node));
     }
+    using node_type = typename rep_type::node_type;
+    node_type extract(iterator position) {
+        using rep_iterator = typename rep_type::iterator;
+        return t.extract(rep_iterator((typename rep_type::link_type)position.node));
+    }
+    node_type extract(const key_type& x) { return t.extract(x); }
+    iterator insert(node_type&& nh) { return t.insert_equal(std::move(nh)); }
+    void merge(self& source) { t.merge_equal(source.t); }
+
+    // O(log n) relinking; see rb_tree::split() and rb_tree::join()
+    void split(const key_type& k, self& right) { t.split(k, right.t); }
+    void join(self& right) { t.join(right.t); }
     size_type erase(const value_type& x) {
         return t.erase(x);
     }
     void clear() { t.clear(); }
 
     iterator find(const key_type& x) const { return t.find(x); }
+    template <typename ForwardIterator, typename OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        return t.find_many(first, last, out);
+    }
     size_type count(const key_type& x) const { return t.count(x); }
+    iterator select(size_type k) const { return t.select(k); }
+    size_type rank(const key_type& x) const { return t.rank(x); }
     iterator lower_bound(const key_type& x) const {
         return t.lower_bound(x);
     }
     iterator upper_bound(const key_type x) const {
         return t.upper_bound(x);
     }
+    std::pair<iterator, iterator> equal_range(const key_type& x) const {
+        return t.equal_range(x);
+    }
+
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& x) const { return t.find(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    size_type count(const K& x) const { return t.count(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator lower_bound(const K& x) const { return t.lower_bound(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator upper_bound(const K& x) const { return t.upper_bound(x); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    std::pair<iterator, iterator> equal_range(const K& x) const { return t.equal_range(x); }
 };
 
 }
\ No newline at end of file
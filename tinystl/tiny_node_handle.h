@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cassert>
+#include <iso646.h>
+#include <utility>
+#include "tiny_construct.h"
+#include "tiny_alloc.h"
+
+namespace Tiny
+{
+
+// owns one node unlinked from a container by extract(); inserting it into a
+// container of the same node type relinks it without copying the value. An
+// empty handle owns nothing. Dropping a non-empty handle frees the node
+template <typename Node, typename Value, typename Alloc>
+class __node_handle
+{
+public:
+    using value_type = Value;
+    using node_pointer = Node*;
+
+protected:
+    using node_allocator = simple_alloc<Node, Alloc>;
+    node_pointer node;
+    value_type* val;
+
+    void reset() {
+        if (node == nullptr) return;
+        destroy(val);
+        node_allocator::deallocate(node);
+        node = nullptr;
+        val = nullptr;
+    }
+
+public:
+    __node_handle() : node(nullptr), val(nullptr) { }
+    __node_handle(node_pointer n, value_type* v) : node(n), val(v) { }
+    __node_handle(const __node_handle&) = delete;
+    __node_handle& operator=(const __node_handle&) = delete;
+    __node_handle(__node_handle&& x) : node(x.node), val(x.val) {
+        x.node = nullptr;
+        x.val = nullptr;
+    }
+    __node_handle& operator=(__node_handle&& x) {
+        if (this == &x) return *this;
+        reset();
+        node = x.node, val = x.val;
+        x.node = nullptr, x.val = nullptr;
+        return *this;
+    }
+    ~__node_handle() { reset(); }
+
+    bool empty() const { return node == nullptr; }
+    explicit operator bool() const { return node != nullptr; }
+    value_type& value() const {
+        assert(node != nullptr);
+        return *val;
+    }
+    void swap(__node_handle& x) {
+        std::swap(node, x.node);
+        std::swap(val, x.val);
+    }
+
+    // used by the containers to take the node back
+    node_pointer release() {
+        node_pointer n = node;
+        node = nullptr;
+        val = nullptr;
+        return n;
+    }
+    node_pointer get() const { return node; }
+};
+
+}
@@ -18,6 +18,9 @@ protected:
     Sequence c;
 
 public:
+    queue() = default;
+    explicit queue(const Sequence& s) : c(s) { }
+
     bool empty() const { return c.empty(); }
     size_type size() const { return c.size(); }
     reference front() { return c.front(); }
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <iso646.h>
+#include "tiny_construct.h"
+#include "tiny_alloc.h"
+#include "tiny_iterator.h"
+#include "tiny_chain.h"
+
+namespace Tiny
+{
+
+// also the bucket chain node of hashtable
+template <typename T>
+struct __slist_node
+{
+    using node_pointer = __slist_node<T>*;
+    node_pointer next;
+    T val;
+};
+
+template <typename T, typename Ref, typename Ptr>
+struct __slist_iterator
+{
+    using iterator = __slist_iterator<T, T&, T*>;
+    using self = __slist_iterator<T, Ref, Ptr>;
+
+    using iterator_category = forward_iterator_tag;
+    using value_type = T;
+    using pointer = Ptr;
+    using reference = Ref;
+    using link_type = __slist_node<T>*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    link_type node;
+
+    __slist_iterator() { }
+    __slist_iterator(link_type x) : node(x) { }
+    __slist_iterator(const iterator& x) : node(x.node) { }
+    self& operator=(const self&) = default;
+
+    bool operator==(const self& x) const { return node == x.node; }
+    bool operator!=(const self& x) const { return node != x.node; }
+    reference operator*() const { return node->val; }
+    pointer operator->() const { return &operator*(); }
+
+    self& operator++() {
+        node = node->next;
+        return *this;
+    }
+    self operator++(int) {
+        self tmp = *this;
+        node = node->next;
+        return tmp;
+    }
+};
+
+// the header node is allocated like list's, but only its next is used;
+// the last element points to nullptr, which is end()
+template <typename T, typename Alloc = alloc>
+class slist
+{
+protected:
+    using slist_node = __slist_node<T>;
+    using slist_node_allocator = simple_alloc<slist_node, Alloc>;
+public:
+    using value_type = T;
+    using pointer = value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = __slist_iterator<T, T&, T*>;
+    using const_iterator = __slist_iterator<T, const T&, const T*>;
+    using link_type = slist_node*;
+
+protected:
+    link_type head;
+    size_type node_count;
+    link_type get_node() { return slist_node_allocator::allocate(); }
+    void put_node(link_type p) { slist_node_allocator::deallocate(p); }
+    link_type create_node(const T& x) {
+        link_type p = get_node();
+        try {
+            construct(&p->val, x);
+        }
+        catch (...) {
+            put_node(p);
+            throw;
+        }
+        return p;
+    }
+    void destroy_node(link_type p) {
+        destroy(&p->val);
+        put_node(p);
+    }
+    void empty_initialized() {
+        head = get_node();
+        head->next = nullptr;
+        node_count = 0;
+    }
+    // moves (before_first, before_last] to just after position
+    static void transfer_after(link_type position, link_type before_first, link_type before_last) {
+        if (position == before_first or position == before_last) return;
+        link_type first = before_first->next;
+        before_first->next = before_last->next;
+        before_last->next = position->next;
+        position->next = first;
+    }
+
+public:
+    iterator before_begin() { return head; }
+    iterator begin() { return head->next; }
+    iterator end() { return nullptr; }
+    const_iterator before_begin() const { return head; }
+    const_iterator begin() const { return head->next; }
+    const_iterator end() const { return nullptr; }
+    bool empty() const { return head->next == nullptr; }
+    size_type size() const { return node_count; }
+    reference front() { return head->next->val; }
+    const_reference front() const { return head->next->val; }
+
+    slist() { empty_initialized(); }
+    ~slist() { clear(), put_node(head); }
+    slist(const slist&);
+    slist(slist&&);
+    template <typename InputIterator, typename = typename
+              std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    slist(InputIterator first, InputIterator last);
+    slist& operator=(const slist&);
+    void swap(slist&);
+
+    iterator insert_after(iterator position, const T& x) {
+        link_type tmp = create_node(x);
+        tmp->next = position.node->next;
+        position.node->next = tmp;
+        node_count++;
+        return tmp;
+    }
+    template <typename InputIterator, typename = typename
+              std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    iterator insert_after(iterator position, InputIterator first, InputIterator last);
+    void push_front(const T& x) { insert_after(before_begin(), x); }
+    iterator erase_after(iterator position) {
+        link_type tmp = position.node->next;
+        position.node->next = tmp->next;
+        destroy_node(tmp);
+        node_count--;
+        return position.node->next;
+    }
+    iterator erase_after(iterator before_first, iterator last);
+    void pop_front() { erase_after(before_begin()); }
+
+    void splice_after(iterator position, slist&);
+    void splice_after(iterator position, slist&, iterator before_i);
+    void splice_after(iterator position, slist&, iterator before_first, iterator last);
+    void clear();
+    void remove(const T& value);
+    void reverse();
+    void merge(slist& x) { merge(x, std::less<T>()); }
+    template <typename Compare>
+    void merge(slist&, Compare comp);
+    void sort() { sort(std::less<T>()); }
+    template <typename Compare>
+    void sort(Compare comp);
+
+};
+
+template <typename T, typename Alloc>
+slist<T, Alloc>::slist(const slist& x)
+{
+    empty_initialized();
+    try {
+        insert_after(before_begin(), x.begin(), x.end());
+    }
+    catch (...) {
+        clear();
+        put_node(head);
+        throw;
+    }
+}
+
+template <typename T, typename Alloc>
+slist<T, Alloc>::slist(slist&& x)
+{
+    empty_initialized();
+    swap(x);
+}
+
+template <typename T, typename Alloc>
+template <typename InputIterator, typename>
+slist<T, Alloc>::slist(InputIterator first, InputIterator last)
+{
+    empty_initialized();
+    try {
+        insert_after(before_begin(), first, last);
+    }
+    catch (...) {
+        clear();
+        put_node(head);
+        throw;
+    }
+}
+
+template <typename T, typename Alloc>
+slist<T, Alloc>& slist<T, Alloc>::operator=(const slist& x)
+{
+    if (this == &x) return *this;
+    slist tmp(x);
+    swap(tmp);
+    return *this;
+}
+
+template <typename T, typename Alloc>
+void slist<T, Alloc>::swap(slist& x)
+{
+    std::swap(head, x.head);
+    std::swap(node_count, x.node_count);
+}
+
+template <typename T, typename Alloc>
+template <typename InputIterator, typename>
+auto slist<T, Alloc>::insert_after(iterator position, InputIterator first, InputIterator last) -> iterator
+{
+    for (; first != last; ++first)
+        position = insert_after(position, *first);
+    return position;
+}
+
+template <typename T, typename Alloc>
+auto slist<T, Alloc>::erase_after(iterator before_first, iterator last) -> iterator
+{
+    link_type cur = before_first.node->next;
+    while (cur != last.node) {
+        link_type tmp = cur;
+        cur = cur->next;
+        destroy_node(tmp);
+        node_count--;
+    }
+    before_first.node->next = last.node;
+    return last;
+}
+
+template <typename T, typename Alloc>
+void slist<T, Alloc>::clear()
+{
+    erase_after(before_begin(), end());
+}
+
+template <typename T, typename Alloc>
+void slist<T, Alloc>::splice_after(iterator position, slist& x)
+{
+    if (x.empty() or this == &x) return;
+    link_type before_last = x.head;
+    while (before_last->next != nullptr)
+        before_last = before_last->next;
+    transfer_after(position.node, x.head, before_last);
+    node_count += x.node_count;
+    x.node_count = 0;
+}
+
+template <typename T, typename Alloc>
+void slist<T, Alloc>::splice_after(iterator position, slist& x, iterator before_i)
+{
+    if (before_i.node->next == nullptr) return;
+    transfer_after(position.node, before_i.node, before_i.node->next);
+    if (this != &x) {
+        node_count++;
+        x.node_count--;
+    }
+}
+
+// moves (before_first, last); linear in the length of the range
+template <typename T, typename Alloc>
+void slist<T, Alloc>::splice_after(iterator position, slist& x, iterator before_first, iterator last)
+{
+    if (before_first.node->next == last.node) return;
+    size_type n = 1;
+    link_type before_last = before_first.node->next;
+    for (; before_last->next != last.node; before_last = before_last->next)
+        n++;
+    transfer_after(position.node, before_first.node, before_last);
+    if (this != &x) {
+        node_count += n;
+        x.node_count -= n;
+    }
+}
+
+template <typename T, typename Alloc>
+void slist<T, Alloc>::remove(const T& value)
+{
+    link_type cur = head;
+    while (cur->next != nullptr)
+    {
+        if (cur->next->val == value)
+            erase_after(cur);
+        else
+            cur = cur->next;
+    }
+}
+
+template <typename T, typename Alloc>
+void slist<T, Alloc>::reverse()
+{
+    link_type result = nullptr;
+    link_type cur = head->next;
+    while (cur != nullptr)
+    {
+        link_type next = cur->next;
+        cur->next = result;
+        result = cur;
+        cur = next;
+    }
+    head->next = result;
+}
+
+template <typename T, typename Alloc>
+template <typename Compare>
+void slist<T, Alloc>::merge(slist& x, Compare comp)
+{
+    if (this == &x) return;
+    // x hands all its nodes over first, so a throwing comp leaves them here
+    link_type b = x.head->next;
+    x.head->next = nullptr;
+    node_count += x.node_count;
+    x.node_count = 0;
+    __merge_chain(head->next, b, &slist_node::val, comp);
+}
+
+// merge sort straight on the chain, as list::sort does
+template <typename T, typename Alloc>
+template <typename Compare>
+void slist<T, Alloc>::sort(Compare comp)
+{
+    __sort_chain(head->next, &slist_node::val, comp);
+}
+
+}
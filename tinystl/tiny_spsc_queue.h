@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include "tiny_alloc.h"
+#include "tiny_construct.h"
+#include "tiny_circular_buffer.h"   // for __cb_capacity()
+#include "tiny_sync.h"
+
+namespace Tiny
+{
+
+// single producer, single consumer; the pool allocator is not thread-safe, so
+// the buffer comes from malloc_alloc by default
+
+template <typename T, typename Alloc = malloc_alloc>
+class spsc_queue
+{
+public:
+    using value_type = T;
+    using pointer = value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+
+protected:
+    using data_allocator = simple_alloc<value_type, Alloc>;
+
+    alignas(__cache_line_size) std::atomic<size_type> head;
+    size_type cached_tail;
+    std::atomic<unsigned> producer_waiters;
+    alignas(__cache_line_size) std::atomic<size_type> tail;
+    size_type cached_head;
+    std::atomic<unsigned> consumer_waiters;
+    alignas(__cache_line_size) pointer buf;
+    size_type mask;
+
+public:
+    explicit spsc_queue(size_type n)
+        : head(0), cached_tail(0), producer_waiters(0),
+          tail(0), cached_head(0), consumer_waiters(0)
+    {
+        buf = data_allocator::allocate(__cb_capacity(n));
+        mask = __cb_capacity(n) - 1;
+    }
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+    ~spsc_queue() {
+        size_type t = tail.load(std::memory_order_acquire);
+        for (size_type h = head.load(std::memory_order_relaxed); h != t; h++)
+            destroy(&buf[h & mask]);
+        data_allocator::deallocate(buf, mask + 1);
+    }
+
+    size_type capacity() const { return mask + 1; }
+    size_type size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+
+    // producer side
+    bool try_push(const T&);
+    void push(const T&);
+    template <typename InputIterator>
+    size_type push_n(InputIterator first, size_type n);
+
+    // consumer side
+    bool try_pop(T&);
+    void pop(T&);
+    template <typename OutputIterator>
+    size_type pop_n(OutputIterator result, size_type n);
+};
+
+template <typename T, typename Alloc>
+bool spsc_queue<T, Alloc>::try_push(const T& x)
+{
+    const size_type t = tail.load(std::memory_order_relaxed);
+    if (t - cached_head == capacity()) {
+        cached_head = head.load(std::memory_order_acquire);
+        if (t - cached_head == capacity())
+            return false;
+    }
+    construct(&buf[t & mask], x);
+    tail.store(t + 1, std::memory_order_release);
+    __atomic_notify_one(tail, consumer_waiters);
+    return true;
+}
+
+template <typename T, typename Alloc>
+void spsc_queue<T, Alloc>::push(const T& x)
+{
+    unsigned spins = 0;
+    while (!try_push(x)) {
+        size_type h = head.load(std::memory_order_acquire);
+        if (tail.load(std::memory_order_relaxed) - h == capacity())
+            __atomic_wait(head, h, producer_waiters, spins);
+    }
+}
+
+template <typename T, typename Alloc>
+template <typename InputIterator>
+auto spsc_queue<T, Alloc>::push_n(InputIterator first, size_type n) -> size_type
+{
+    const size_type t = tail.load(std::memory_order_relaxed);
+    if (capacity() - (t - cached_head) < n)
+        cached_head = head.load(std::memory_order_acquire);
+    n = std::min(n, capacity() - (t - cached_head));
+    if (n == 0) return 0;
+
+    for (size_type i = 0; i < n; i++, first++)
+        construct(&buf[(t + i) & mask], *first);
+    tail.store(t + n, std::memory_order_release);
+    __atomic_notify_one(tail, consumer_waiters);
+    return n;
+}
+
+template <typename T, typename Alloc>
+bool spsc_queue<T, Alloc>::try_pop(T& x)
+{
+    const size_type h = head.load(std::memory_order_relaxed);
+    if (h == cached_tail) {
+        cached_tail = tail.load(std::memory_order_acquire);
+        if (h == cached_tail)
+            return false;
+    }
+    x = std::move(buf[h & mask]);
+    destroy(&buf[h & mask]);
+    head.store(h + 1, std::memory_order_release);
+    __atomic_notify_one(head, producer_waiters);
+    return true;
+}
+
+template <typename T, typename Alloc>
+void spsc_queue<T, Alloc>::pop(T& x)
+{
+    unsigned spins = 0;
+    while (!try_pop(x)) {
+        size_type t = tail.load(std::memory_order_acquire);
+        if (t == head.load(std::memory_order_relaxed))
+            __atomic_wait(tail, t, consumer_waiters, spins);
+    }
+}
+
+template <typename T, typename Alloc>
+template <typename OutputIterator>
+auto spsc_queue<T, Alloc>::pop_n(OutputIterator result, size_type n) -> size_type
+{
+    const size_type h = head.load(std::memory_order_relaxed);
+    if (cached_tail - h < n)
+        cached_tail = tail.load(std::memory_order_acquire);
+    n = std::min(n, cached_tail - h);
+    if (n == 0) return 0;
+
+    for (size_type i = 0; i < n; i++, result++) {
+        *result = std::move(buf[(h + i) & mask]);
+        destroy(&buf[(h + i) & mask]);
+    }
+    head.store(h + n, std::memory_order_release);
+    __atomic_notify_one(head, producer_waiters);
+    return n;
+}
+
+}
@@ -14,18 +14,21 @@ class stack
 public:
     using value_type = typename Sequence::value_type;
     using size_type = typename Sequence::size_type;
-    using refrence = typename Sequence::reference;
+    using reference = typename Sequence::reference;
     using const_reference = typename Sequence::const_reference;
 
 protected:
     Sequence c;
 
 public:
+    stack() = default;
+    explicit stack(const Sequence& s) : c(s) { }
+
     bool empty() const { return c.empty(); }
     size_type size() const { return c.size(); }
     reference top() { return c.back(); }
     const_reference top() const { return c.back(); }
-    void push(const value_type& x) { c.push_back(); }
+    void push(const value_type& x) { c.push_back(x); }
     void pop() { c.pop_back(); }
 };
 
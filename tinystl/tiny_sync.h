@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace Tiny
+{
+
+const size_t __cache_line_size = 64;
+
+// spin briefly, then sleep in std::atomic<>::wait(), or before C++20 on a condition
+// variable picked by the address of the atomic; the waiter count lets the other side
+// skip the wake-up while nobody sleeps
+
+#if !defined(__cpp_lib_atomic_wait)
+struct __wait_bucket
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+// atomics that hash to the same bucket share it, so wake-ups go to every sleeper
+inline __wait_bucket& __wait_bucket_of(const void* p)
+{
+    static __wait_bucket table[16];
+    return table[(reinterpret_cast<uintptr_t>(p) / __cache_line_size) % 16];
+}
+
+inline void __wait_bucket_notify(const void* p)
+{
+    __wait_bucket& b = __wait_bucket_of(p);
+    // a sleeper that has checked the value holds the mutex until it is waiting
+    { std::lock_guard<std::mutex> lock(b.mutex); }
+    b.cond.notify_all();
+}
+#endif
+
+template <typename T>
+void __atomic_wait(const std::atomic<T>& a, T old, std::atomic<unsigned>& waiters, unsigned& spins)
+{
+    if (spins < 64) {
+        spins++;
+        return;
+    }
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__cpp_lib_atomic_wait)
+    a.wait(old, std::memory_order_seq_cst);
+#else
+    __wait_bucket& b = __wait_bucket_of(&a);
+    {
+        std::unique_lock<std::mutex> lock(b.mutex);
+        while (a.load(std::memory_order_seq_cst) == old)
+            b.cond.wait(lock);
+    }
+#endif
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+void __atomic_notify_one(std::atomic<T>& a, const std::atomic<unsigned>& waiters)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0) return;
+#if defined(__cpp_lib_atomic_wait)
+    a.notify_one();
+#else
+    __wait_bucket_notify(&a);
+#endif
+}
+
+template <typename T>
+void __atomic_notify_all(std::atomic<T>& a, const std::atomic<unsigned>& waiters)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0) return;
+#if defined(__cpp_lib_atomic_wait)
+    a.notify_all();
+#else
+    __wait_bucket_notify(&a);
+#endif
+}
+
+// test-and-test-and-set lock for short critical sections; yields after a while
+// so waiters do not starve the holder on a busy core
+
+struct __spin_lock
+{
+    std::atomic<bool> locked;
+
+    __spin_lock() : locked(false) { }
+    bool try_lock() {
+        return !locked.load(std::memory_order_relaxed) and !locked.exchange(true, std::memory_order_acquire);
+    }
+    void lock() {
+        unsigned spins = 0;
+        while (!try_lock())
+            if (++spins >= 64)
+                std::this_thread::yield();
+    }
+    void unlock() { locked.store(false, std::memory_order_release); }
+};
+
+// a fixed set of worker threads, started on first use, for fork-join code to
+// hand its second half of work to. A task that no worker has taken yet when
+// its owner wants the result is run by the owner, so a waiting thread only
+// ever waits for a task that is already running
+
+struct __pool_task
+{
+    void (*run)(__pool_task*);
+    __pool_task* next;
+    bool done;
+};
+
+class __task_pool
+{
+protected:
+    std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable finished;
+    __pool_task* queue;
+    bool stopping;
+    std::thread* workers;
+    unsigned worker_count;
+
+    void worker_loop();
+
+public:
+    explicit __task_pool(unsigned threads);
+    __task_pool(const __task_pool&) = delete;
+    __task_pool& operator=(const __task_pool&) = delete;
+    ~__task_pool();
+
+    unsigned size() const { return worker_count; }
+    void submit(__pool_task* t);
+    // runs t here if it is still queued, otherwise waits for it
+    void wait(__pool_task* t);
+};
+
+inline __task_pool::__task_pool(unsigned threads)
+    : queue(nullptr), stopping(false), workers(nullptr), worker_count(0)
+{
+    if (threads == 0) return;
+    workers = new std::thread[threads];
+    for (; worker_count < threads; worker_count++) {
+        try {
+            workers[worker_count] = std::thread([this] { worker_loop(); });
+        }
+        catch (const std::system_error&) {
+            break;
+        }
+    }
+}
+
+inline __task_pool::~__task_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work.notify_all();
+    for (unsigned i = 0; i < worker_count; i++)
+        workers[i].join();
+    delete[] workers;
+}
+
+inline void __task_pool::worker_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        while (queue == nullptr and !stopping)
+            work.wait(lock);
+        if (queue == nullptr) return;
+        __pool_task* t = queue;
+        queue = t->next;
+        lock.unlock();
+        t->run(t);
+        lock.lock();
+        t->done = true;
+        finished.notify_all();
+    }
+}
+
+inline void __task_pool::submit(__pool_task* t)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        t->done = false;
+        t->next = queue;
+        queue = t;
+    }
+    work.notify_one();
+}
+
+inline void __task_pool::wait(__pool_task* t)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (__pool_task** p = &queue; *p != nullptr; p = &(*p)->next)
+        if (*p == t) {
+            *p = t->next;
+            lock.unlock();
+            t->run(t);
+            return;
+        }
+    while (!t->done)
+        finished.wait(lock);
+}
+
+// one worker less than the hardware threads, as the caller works too
+inline __task_pool& __global_task_pool()
+{
+    static __task_pool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+}
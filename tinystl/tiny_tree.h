@@ -6,8 +6,23 @@
 #include "tiny_alloc.h"
 #include "tiny_iterator.h"
 #include "tiny_functional.h"
+#include "tiny_node_handle.h"
+#include "tiny_sync.h"
 #include <iso646.h>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <exception>
+#include <thread>
 #include <utility>
+#include <type_traits>
+
+// lookups fetch both children of a node while its key is compared
+#if defined(__GNUC__)
+#define __RB_TREE_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define __RB_TREE_PREFETCH(p) ((void)0)
+#endif
 
 namespace Tiny
 {
@@ -16,16 +31,35 @@ using __rb_tree_color_type = bool;
 const __rb_tree_color_type __rb_tree_red = false;
 const __rb_tree_color_type __rb_tree_black = true;
 
-struct __rb_tree_node_base
+// the two node layouts, picked by the NodeBase parameter of rb_tree and the
+// wrappers. The default keeps the color in a field of its own; compact_node
+// keeps it in the low bit of the parent pointer, as nodes are at least
+// pointer aligned, which saves a padded word per node
+template <bool Compact>
+struct __rb_tree_node_base_template;
+
+template <>
+struct __rb_tree_node_base_template<false>
 {
     using color_type = __rb_tree_color_type;
-    using base_ptr = __rb_tree_node_base*;
+    using base_ptr = __rb_tree_node_base_template<false>*;
+    static const bool compact = false;
 
     color_type color;
     base_ptr parent;
     base_ptr left;
     base_ptr right;
-    
+
+    base_ptr get_parent() const { return parent; }
+    void set_parent(base_ptr p) { parent = p; }
+    color_type get_color() const { return color; }
+    void set_color(color_type c) { color = c; }
+    void set_parent_color(base_ptr p, color_type c) {
+        parent = p;
+        color = c;
+    }
+    base_ptr& root_slot() { return parent; }
+
     static base_ptr minimum(base_ptr x) {
         while (x->left != 0) x = x->left;
         return x;
@@ -36,16 +70,87 @@ struct __rb_tree_node_base
     }
 };
 
-template <typename Value>
-struct __rb_tree_node : public __rb_tree_node_base
+template <>
+struct __rb_tree_node_base_template<true>
+{
+    using color_type = __rb_tree_color_type;
+    using base_ptr = __rb_tree_node_base_template<true>*;
+    static const bool compact = true;
+
+    base_ptr parent_color;
+    base_ptr left;
+    base_ptr right;
+
+    base_ptr get_parent() const { return base_ptr(uintptr_t(parent_color) & ~uintptr_t(1)); }
+    void set_parent(base_ptr p) { parent_color = base_ptr(uintptr_t(p) | (uintptr_t(parent_color) & 1)); }
+    color_type get_color() const { return color_type(uintptr_t(parent_color) & 1); }
+    void set_color(color_type c) {
+        parent_color = base_ptr((uintptr_t(parent_color) & ~uintptr_t(1)) | uintptr_t(c));
+    }
+    // the only write that does not read the word first, so fresh nodes start here
+    void set_parent_color(base_ptr p, color_type c) { parent_color = base_ptr(uintptr_t(p) | uintptr_t(c)); }
+    // the header is always red (a zero bit), so its parent word is exactly
+    // the root pointer and can be handed out by reference
+    base_ptr& root_slot() { return parent_color; }
+
+    static base_ptr minimum(base_ptr x) {
+        while (x->left != 0) x = x->left;
+        return x;
+    }
+    static base_ptr maximum(base_ptr x) {
+        while (x->right != 0) x = x->right;
+        return x;
+    }
+};
+
+using __rb_tree_node_base = __rb_tree_node_base_template<false>;
+using compact_node = __rb_tree_node_base_template<true>;
+
+// order statistics: each node also keeps the size of its subtree. Pass
+// order_statistics (or compact_order_statistics) as the NodeBase of rb_tree
+// or of the wrappers to get select(), rank() and an O(log n) distance()
+// between iterators
+template <bool Compact>
+struct __rb_tree_os_node_base : public __rb_tree_node_base_template<Compact>
 {
-    using link_type = __rb_tree_node<Value>*;
+    size_t size;
+};
+
+using order_statistics = __rb_tree_os_node_base<false>;
+using compact_order_statistics = __rb_tree_os_node_base<true>;
+
+template <bool Compact>
+inline size_t __rb_tree_os_size(__rb_tree_node_base_template<Compact>* x)
+{
+    return x ? static_cast<__rb_tree_os_node_base<Compact>*>(x)->size : 0;
+}
+
+// in-order position of x; the header (end()) gives the size of the tree
+template <bool Compact>
+inline size_t __rb_tree_os_index(__rb_tree_node_base_template<Compact>* x)
+{
+    if (x->get_parent() == nullptr)
+        return 0;
+    if (x->get_color() == __rb_tree_red and x->get_parent()->get_parent() == x)
+        return __rb_tree_os_size(x->get_parent());
+    size_t r = __rb_tree_os_size(x->left);
+    for (; x->get_parent()->get_parent() != x; x = x->get_parent())
+        if (x == x->get_parent()->right)
+            r += __rb_tree_os_size(x->get_parent()->left) + 1;
+    return r;
+}
+
+template <typename Value, typename NodeBase = __rb_tree_node_base>
+struct __rb_tree_node : public NodeBase
+{
+    using link_type = __rb_tree_node<Value, NodeBase>*;
     Value value_field;
 };
 
+template <bool Compact>
 struct __rb_tree_base_iterator
 {
-    using base_ptr = __rb_tree_node_base::base_ptr;
+    using base_ptr = typename __rb_tree_node_base_template<Compact>::base_ptr;
     using iterator_category = bidirectional_iterator_tag;
     using difference_type = ptrdiff_t;
 
@@ -60,9 +165,9 @@ struct __rb_tree_base_iterator
         }
         else
         {
-            base_ptr y = node->parent;
+            base_ptr y = node->get_parent();
             while (node == y->right)
-                node = y, y = y->parent;
+                node = y, y = y->get_parent();
             if (node->right != y)
                 node = y;
         }
@@ -70,8 +175,8 @@ struct __rb_tree_base_iterator
 
     void decrement()
     {
-        if (node->color == __rb_tree_red and
-            node->parent->parent == node)
+        if (node->get_color() == __rb_tree_red and
+            node->get_parent()->get_parent() == node)
         {
             node = node->right;
             return;
@@ -85,24 +190,28 @@ struct __rb_tree_base_iterator
         }
         else
         {
-            base_ptr y = node->parent;
+            base_ptr y = node->get_parent();
             while (node == y->left)
-                node = y, y = y->parent;
+                node = y, y = y->get_parent();
             node = y;
         }
     }
 };
 
-template <typename Value, typename Ref, typename Ptr>
-struct __rb_tree_iterator : public __rb_tree_base_iterator
+template <typename Value, typename Ref, typename Ptr, typename NodeBase = __rb_tree_node_base>
+struct __rb_tree_iterator : public __rb_tree_base_iterator<NodeBase::compact>
 {
     using value_type = Value;
     using reference = Ref;
     using pointer = Ptr;
-    using iterator = __rb_tree_iterator<Value, Value&, Value*>;
-    using const_iterator = __rb_tree_iterator<Value, const Value&, const Value*>;
-    using self = __rb_tree_iterator<Value, Ref, Ptr>;
-    using link_type = __rb_tree_node<Value>*;
+    using iterator = __rb_tree_iterator<Value, Value&, Value*, NodeBase>;
+    using const_iterator = __rb_tree_iterator<Value, const Value&, const Value*, NodeBase>;
+    using self = __rb_tree_iterator<Value, Ref, Ptr, NodeBase>;
+    using link_type = __rb_tree_node<Value, NodeBase>*;
+    using base = __rb_tree_base_iterator<NodeBase::compact>;
+    using base::node;
+    using base::increment;
+    using base::decrement;
 
     __rb_tree_iterator() = default;
     __rb_tree_iterator(link_type x) { node = x; }
@@ -135,13 +244,21 @@ struct __rb_tree_iterator : public __rb_tree_base_iterator
     }
 };
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc = alloc>
+template <typename Value, typename Ref, typename Ptr, bool Compact>
+inline ptrdiff_t distance(__rb_tree_iterator<Value, Ref, Ptr, __rb_tree_os_node_base<Compact>> first,
+                          __rb_tree_iterator<Value, Ref, Ptr, __rb_tree_os_node_base<Compact>> last)
+{
+    return ptrdiff_t(__rb_tree_os_index(last.node)) - ptrdiff_t(__rb_tree_os_index(first.node));
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc = alloc,
+          typename NodeBase = __rb_tree_node_base>
 class rb_tree
 {
 protected:
     using void_pointer = void*;
-    using base_ptr = __rb_tree_node_base*;
-    using rb_tree_node = __rb_tree_node<Value>;
+    using base_ptr = typename NodeBase::base_ptr;
+    using rb_tree_node = __rb_tree_node<Value, NodeBase>;
     using rb_tree_node_allocator = simple_alloc<rb_tree_node, Alloc>;
     using color_type = __rb_tree_color_type;
 
@@ -155,7 +272,9 @@ public:
     using link_type = rb_tree_node*;
     using size_type = size_t;
     using difference_type = ptrdiff_t;
-    using self = rb_tree<Key, Value, KeyOfValue, Compare, Alloc>;
+    using self = rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>;
+
+    static const bool order_statistics = std::is_base_of<__rb_tree_os_node_base<NodeBase::compact>, NodeBase>::value;
 
 protected:
     link_type get_node() { return rb_tree_node_allocator::allocate(); }
@@ -174,10 +293,35 @@ protected:
         return tmp;
     }
 
-    link_type clone_node(link_type x)
+    // bulk copies take raw nodes from the allocator as one chain, carved
+    // from a single chunk when the pool has to grow
+    link_type take_node(link_type& spare, size_type want) {
+        if (spare == nullptr)
+            spare = rb_tree_node_allocator::allocate_chain(int(std::min<size_type>(want, INT_MAX)));
+        link_type p = spare;
+        spare = rb_tree_node_allocator::chain_next(p);
+        return p;
+    }
+    void put_chain(link_type spare) {
+        while (spare != nullptr) {
+            link_type next = rb_tree_node_allocator::chain_next(spare);
+            put_node(spare);
+            spare = next;
+        }
+    }
+
+    link_type clone_node(link_type x, link_type& spare, size_type want)
     {
-        link_type tmp = create_node(x->value_field);
-        tmp->color = x->color;
+        link_type tmp = take_node(spare, want);
+        try {
+            construct(&tmp->value_field, x->value_field);
+        }
+        catch (...) {
+            put_node(tmp);
+            throw;
+        }
+        tmp->set_parent_color(nullptr, x->get_color());
+        if (order_statistics) subtree_size(tmp) = subtree_size(x);
         tmp->left = nullptr;
         tmp->right = nullptr;
         return tmp;
@@ -191,64 +335,189 @@ protected:
 
 protected:
     size_type node_count;
+    // the header lives inside the tree object, so an empty tree owns no
+    // memory and a move only has to re-point the root at the new header
+    NodeBase header_node;
     link_type header;
     Compare key_compare;
 
-    link_type& root() const { return (link_type&)header->parent; }
+    link_type& root() const { return (link_type&)header->root_slot(); }
     link_type& leftmost() const { return (link_type&)header->left; }
     link_type& rightmost() const { return (link_type&)header->right; }
     
     static link_type& left(link_type x) { return (link_type&)x->left; }
     static link_type& right(link_type x) { return (link_type&)x->right; }
-    static link_type& parent(link_type x) { return (link_type&)x->parent; }
+    static link_type parent(link_type x) { return (link_type)x->get_parent(); }
     static reference value(link_type x) { return x->value_field; }
     static const Key& key(link_type x) { return KeyOfValue()(value(x)); }
-    static color_type& color(link_type x) { return x->color; }
+    static color_type color(link_type x) { return x->get_color(); }
 
     static link_type& left(base_ptr x) { return (link_type&)x->left; }
     static link_type& right(base_ptr x) { return (link_type&)x->right; }
-    static link_type& parent(base_ptr x) { return (link_type&)x->parent; }
+    static link_type parent(base_ptr x) { return (link_type)x->get_parent(); }
     static reference value(base_ptr x) { return link_type(x)->value_field; }
     static const Key& key(base_ptr x) { return KeyOfValue()(value(link_type(x))); }
-    static color_type& color(base_ptr x) { return link_type(x)->color; }
+    static color_type color(base_ptr x) { return x->get_color(); }
+    // only meaningful when order_statistics
+    static size_type& subtree_size(base_ptr x) { return static_cast<__rb_tree_os_node_base<NodeBase::compact>*>(x)->size; }
 
     static link_type minimum(link_type x) {
-        return (link_type)__rb_tree_node_base::minimum(x);
+        return (link_type)NodeBase::minimum(x);
     }
     static link_type maximum(link_type x) {
-        return (link_type)__rb_tree_node_base::maximum(x);
+        return (link_type)NodeBase::maximum(x);
     }
 
     void __rb_tree_rotate_left(base_ptr, base_ptr& root);
     void __rb_tree_rotate_right(base_ptr, base_ptr& root);
-    void __rb_tree_rebalance_insert(base_ptr, base_ptr& root);
+    bool __rb_tree_rebalance_insert(base_ptr, base_ptr& root);
     base_ptr __rb_tree_rebalance_erase(base_ptr, base_ptr& root);
     
 public:
-    using iterator = __rb_tree_iterator<value_type, reference, pointer>;
-    using const_iterator = __rb_tree_iterator<value_type, const_reference, const_pointer>;
+    using iterator = __rb_tree_iterator<value_type, reference, pointer, NodeBase>;
+    using const_iterator = __rb_tree_iterator<value_type, const_reference, const_pointer, NodeBase>;
+
+    using node_type = __node_handle<rb_tree_node, value_type, Alloc>;
 
 private:
-    iterator __insert(base_ptr x, base_ptr y, const value_type& v);
-    link_type __copy(link_type x, link_type p);
+    iterator __insert(base_ptr x, base_ptr y, const value_type& v) {
+        return __link(x, y, create_node(v));
+    }
+    iterator __link(base_ptr x, base_ptr y, link_type z);
+    bool __insert_unique_pos(const Key& k, link_type& x, link_type& y, iterator& j);
+    link_type __unlink(iterator position) {
+        base_ptr z = __rb_tree_rebalance_erase(position.node, (base_ptr&)root());
+        node_count--;
+        return (link_type)z;
+    }
+    link_type __copy(link_type x, link_type p, size_type n);
+    // the bounds below x, or y when every key there is smaller (greater)
+    template <typename K>
+    link_type __lower_bound(link_type x, link_type y, const K& k) const;
+    template <typename K>
+    link_type __upper_bound(link_type x, link_type y, const K& k) const;
+    template <typename K>
+    link_type __lower_bound(const K& k) const { return __lower_bound(root(), header, k); }
+    template <typename K>
+    link_type __upper_bound(const K& k) const { return __upper_bound(root(), header, k); }
+    template <typename K>
+    std::pair<link_type, link_type> __equal_range(const K& k) const;
+    template <typename K>
+    link_type __find(const K& k) const;
+    template <typename K>
+    size_type __count(const K& k) const;
+    static const int find_many_lanes = 8;
+    template <typename Iterator, typename ForwardIterator, typename OutputIterator>
+    OutputIterator __find_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const;
     void __erase(link_type x);
+
+    template <typename InputIterator>
+    void __insert_range(InputIterator first, InputIterator last, bool unique, input_iterator_tag);
+    template <typename ForwardIterator>
+    void __insert_range(ForwardIterator first, ForwardIterator last, bool unique, forward_iterator_tag);
+    template <typename ForwardIterator>
+    link_type __build_sorted(ForwardIterator& first, ForwardIterator last, size_type n,
+                             bool unique, int depth, int red_depth);
+
+    // split, join and the set operations work on detached subtrees: a root
+    // whose parent is null, carried with its black height (the number of
+    // black nodes on every path down from it, 0 for an empty tree)
+    struct subtree {
+        link_type root;
+        int height;
+    };
+    // nodes dropped by the set operations, chained through right and freed
+    // once the worker threads are done, as the node allocator is not
+    // thread-safe
+    struct garbage {
+        link_type head = nullptr;
+        link_type tail = nullptr;
+        size_type count = 0;
+        void push(link_type x) {
+            x->right = head;
+            head = x;
+            if (tail == nullptr) tail = x;
+            count++;
+        }
+        void splice(garbage& g) {
+            if (g.head == nullptr) return;
+            g.tail->right = head;
+            head = g.head;
+            if (tail == nullptr) tail = g.tail;
+            count += g.count;
+        }
+    };
+    // subtrees at least this black-high (2^h - 1 nodes) are worth a thread
+    static const int parallel_height = 10;
+    // one step of the set operations: b exposed around its root x, a split
+    // around the key of x (dup is the node of a with that key, if any), and
+    // the results for the two halves
+    struct step {
+        link_type x, dup;
+        subtree al, ar, bl, br, l, r;
+    };
+    using set_operation = subtree (rb_tree::*)(subtree&, subtree&, garbage&, int);
+
+    static void __expose(subtree t, subtree& l, subtree& r);
+    subtree __join(subtree l, link_type k, subtree r);
+    subtree __join2(subtree l, subtree r);
+    subtree __split_last(subtree t, link_type& last);
+    link_type __split(subtree t, const Key& k, subtree& l, subtree& r, bool take_equal);
+    void __split_at(subtree t, link_type pos, subtree& l, subtree& r);
+    void __split_at(subtree t, link_type* path, subtree& l, subtree& r);
+    // runs of equal keys at least this long are cut out by erase() with
+    // splits instead of being unlinked node by node
+    static const size_type erase_split_threshold = 256;
+    // the set operations consume a and b. If Compare throws, a and b are
+    // handed back holding, as two valid trees, every node not yet in g
+    subtree __union(subtree& a, subtree& b, garbage& g, int depth);
+    subtree __intersection(subtree& a, subtree& b, garbage& g, int depth);
+    subtree __difference(subtree& a, subtree& b, garbage& g, int depth);
+    void __step_split(subtree& a, subtree& b, step& s);
+    void __step_recurse(set_operation op, subtree& a, subtree& b, step& s, garbage& g, int depth);
+    void __set_operation(set_operation op, self& x, bool this_first);
+    static void __collect(link_type x, garbage& g);
+    static size_type __count_upto(link_type x, size_type limit);
+    static size_type __subtree_count(subtree t) {
+        return order_statistics ? __rb_tree_os_size(t.root) : __count_upto(t.root, size_type(-1));
+    }
+    static int __parallel_depth();
+    subtree __release();
+    void __adopt(subtree t, size_type n) {
+        __adopt(t.root, t.root ? minimum(t.root) : nullptr, t.root ? maximum(t.root) : nullptr, n);
+    }
+    void __free(garbage& g);
     void init() {
-        header = get_node();
-        color(header) = __rb_tree_red;
+        header = (link_type)&header_node;
+        header->set_parent_color(nullptr, __rb_tree_red);
         root() = nullptr;
         leftmost() = header;
         rightmost() = header;
     }
+    // hangs a detached tree (root r, extremes l and rm, n nodes) off our header
+    void __adopt(link_type r, link_type l, link_type rm, size_type n) {
+        node_count = n;
+        root() = r;
+        if (r == nullptr) {
+            leftmost() = header;
+            rightmost() = header;
+            return;
+        }
+        r->set_parent(header);
+        leftmost() = l;
+        rightmost() = rm;
+    }
 
 public:
     rb_tree(const Compare& comp = Compare())
         : node_count(0), key_compare(comp) { init(); }
     rb_tree(const self&);
-    rb_tree(self&&);
-    ~rb_tree() { clear(), put_node(header); }
+    rb_tree(self&&) noexcept;
+    ~rb_tree() { clear(); }
 
     self& operator=(const self& x);
-    void swap(self& x);
+    self& operator=(self&& x) noexcept;
+    void swap(self& x) noexcept;
     Compare key_comp() const { return key_compare; }
     iterator begin() { return leftmost(); }
     iterator end() { return header; }
@@ -258,89 +527,239 @@ public:
     size_type size() const { return node_count; }
     static size_type max_size() { return size_type(-1); }
 
-    iterator find(const Key&);
-    const_iterator find(const Key&) const;
-    iterator lower_bound(const Key&);
-    iterator upper_bound(const Key&);
-    const_iterator lower_bound(const Key&) const;
-    const_iterator upper_bound(const Key&) const;
-    size_type count(const key_type&) const;
+    iterator find(const Key& k) { return __find(k); }
+    const_iterator find(const Key& k) const { return __find(k); }
+    iterator lower_bound(const Key& k) { return __lower_bound(k); }
+    iterator upper_bound(const Key& k) { return __upper_bound(k); }
+    const_iterator lower_bound(const Key& k) const { return __lower_bound(k); }
+    const_iterator upper_bound(const Key& k) const { return __upper_bound(k); }
+    size_type count(const key_type& k) const { return __count(k); }
+    std::pair<iterator, iterator> equal_range(const Key& k) {
+        std::pair<link_type, link_type> r = __equal_range(k);
+        return std::pair<iterator, iterator>(r.first, r.second);
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const Key& k) const {
+        std::pair<link_type, link_type> r = __equal_range(k);
+        return std::pair<const_iterator, const_iterator>(r.first, r.second);
+    }
+
+    // with a transparent Compare (one that declares is_transparent, such as
+    // std::less<>) lookups take any type the comparator accepts, so no
+    // temporary Key is built
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& k) { return __find(k); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator find(const K& k) const { return __find(k); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator lower_bound(const K& k) { return __lower_bound(k); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator lower_bound(const K& k) const { return __lower_bound(k); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator upper_bound(const K& k) { return __upper_bound(k); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator upper_bound(const K& k) const { return __upper_bound(k); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    size_type count(const K& k) const { return __count(k); }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    std::pair<iterator, iterator> equal_range(const K& k) {
+        std::pair<link_type, link_type> r = __equal_range(k);
+        return std::pair<iterator, iterator>(r.first, r.second);
+    }
+    template <typename K, typename C = Compare, typename = typename C::is_transparent>
+    std::pair<const_iterator, const_iterator> equal_range(const K& k) const {
+        std::pair<link_type, link_type> r = __equal_range(k);
+        return std::pair<const_iterator, const_iterator>(r.first, r.second);
+    }
+
+    // writes find(*i) for every i in [first, last) to out, in order. The
+    // descents are interleaved, which hides most of the memory latency of
+    // trees much larger than the cache
+    template <typename ForwardIterator, typename OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out) {
+        return __find_many<iterator>(first, last, out);
+    }
+    template <typename ForwardIterator, typename OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        return __find_many<const_iterator>(first, last, out);
+    }
     std::pair<iterator, bool> insert_unique(const value_type&);
     iterator insert_equal(const value_type&);
+    iterator insert_unique(iterator hint, const value_type&);
+    iterator insert_equal(iterator hint, const value_type&);
+    template <typename InputIterator>
+    void insert_unique(InputIterator first, InputIterator last) {
+        __insert_range(first, last, true, iterator_category(first));
+    }
+    template <typename InputIterator>
+    void insert_equal(InputIterator first, InputIterator last) {
+        __insert_range(first, last, false, iterator_category(first));
+    }
     void erase(iterator);
     size_type erase(const Key&);
     void clear();
+
+    // node handles: extract() unlinks a node without freeing it, and the
+    // node_type inserts and merge() relink nodes without copying values
+    node_type extract(iterator position) {
+        link_type z = __unlink(position);
+        return node_type(z, &z->value_field);
+    }
+    node_type extract(const Key& k) {
+        iterator i = find(k);
+        return i == end() ? node_type() : extract(i);
+    }
+    std::pair<iterator, bool> insert_unique(node_type&& nh);
+    iterator insert_equal(node_type&& nh);
+    void merge_unique(self& source);
+    void merge_equal(self& source);
+
+    // split() keeps the elements less than k and moves the rest into right,
+    // replacing its contents; join() appends right, whose elements must not
+    // be less than ours, and empties it. Both relink nodes in O(log n);
+    // without order statistics split() also counts the smaller half
+    void split(const Key& k, self& right);
+    void join(self& right);
+
+    // bulk set algebra for insert_unique trees, in O(m log(n/m + 1)) for
+    // sizes m <= n. The result replaces *this and x is left empty; on equal
+    // keys the element of *this is kept. Large inputs recurse on both
+    // halves in parallel on the task pool, so Compare must be safe to call
+    // from several threads. If it throws, nothing leaks: *this and x are
+    // left as valid trees holding between them every element not yet dropped
+    void set_union(self& x);
+    void set_intersection(self& x);
+    void set_difference(self& x);
+
+    // order statistics, 0-based; need NodeBase = order_statistics
+    iterator select(size_type k);
+    const_iterator select(size_type k) const;
+    size_type rank(const Key&) const;
+
+    bool __rb_verify() const;
 };
 
+template <bool Compact>
+inline int __black_count(__rb_tree_node_base_template<Compact>* node, __rb_tree_node_base_template<Compact>* root)
+{
+    int sum = 0;
+    for (; node != nullptr; node = node->get_parent()) {
+        if (node->get_color() == __rb_tree_black) sum++;
+        if (node == root) break;
+    }
+    return sum;
+}
+
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__copy(link_type x, link_type p) -> link_type
+// copies the n nodes under x without recursion: each step clones the
+// children of one node, queues the right child and walks down the left
+// one, so the stack holds at most one entry per level (an rb_tree is
+// never deeper than twice the log of its size, so 128 levels suffice).
+// Every clone is linked at once, so on an exception the partial copy can
+// be freed like any subtree
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__copy(link_type x, link_type p, size_type n) -> link_type
 {
     if (x == nullptr) return nullptr;
 
-    link_type top = clone_node(x);
-    top->parent = p;
+    link_type spare = nullptr;
+    link_type top = nullptr;
+    size_type left_to_copy = n;
+    link_type stack[2 * sizeof(size_type) * 8][2];
+    int depth = 0;
     try {
-        top->right = __copy(x->right);
-        top->left = __copy(x->left);
+        top = clone_node(x, spare, left_to_copy--);
+        top->set_parent(p);
+        stack[depth][0] = x, stack[depth][1] = top, depth++;
+        while (depth > 0)
+        {
+            depth--;
+            link_type src = stack[depth][0];
+            link_type dst = stack[depth][1];
+            while (src != nullptr)
+            {
+                if (right(src) != nullptr) {
+                    link_type r = clone_node(right(src), spare, left_to_copy--);
+                    r->set_parent(dst);
+                    dst->right = r;
+                    stack[depth][0] = right(src), stack[depth][1] = r, depth++;
+                }
+                if (left(src) != nullptr) {
+                    link_type l = clone_node(left(src), spare, left_to_copy--);
+                    l->set_parent(dst);
+                    dst->left = l;
+                    dst = l;
+                }
+                src = left(src);
+            }
+        }
     }
     catch (...) {
+        put_chain(spare);
         __erase(top);
         throw;
     }
+    put_chain(spare);
     return top;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::rb_tree(const self& x)
-    : node_count(x.node_count), key_compare(x.key_comp)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::rb_tree(const self& x)
+    : node_count(0), key_compare(x.key_compare)
 {
     init();
-    try {
-        root() = __copy(x.root(), header);
-    }
-    catch (...) {
-        put_node(root());
-        throw;
-    }
+    if (x.root() == nullptr) return;
+    root() = __copy(x.root(), header, x.node_count);
     leftmost() = minimum(root());
     rightmost() = maximum(root());
+    node_count = x.node_count;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::rb_tree(self&& x)
-    : node_count(x.node_count), header(x.header), key_compare(x.key_compare)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::rb_tree(self&& x) noexcept
+    : node_count(0), key_compare(x.key_compare)
 {
-    x.header = nullptr;
+    init();
+    __adopt(x.root(), x.leftmost(), x.rightmost(), x.node_count);
+    x.__adopt(nullptr, nullptr, nullptr, 0);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::operator=(const self& x) -> self&
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::operator=(const self& x) -> self&
 {
-    node_count = x.node_count;
-    key_compare = x.key_compare;
+    if (this == &x) return *this;
     clear();
-    try {
-        root() = __copy(x.root(), header);
-    }
-    catch (...) {
-        put_node(root());
-        throw;
-    }
+    key_compare = x.key_compare;
+    if (x.root() == nullptr) return *this;
+    root() = __copy(x.root(), header, x.node_count);
     leftmost() = minimum(root());
     rightmost() = maximum(root());
+    node_count = x.node_count;
+    return *this;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::swap(self& x)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::operator=(self&& x) noexcept -> self&
 {
-    swap(node_count, x.node_count);
-    swap(header, x.header);
-    swap(key_compare, x.key_compare);
+    if (this == &x) return *this;
+    clear();
+    key_compare = x.key_compare;
+    __adopt(x.root(), x.leftmost(), x.rightmost(), x.node_count);
+    x.__adopt(nullptr, nullptr, nullptr, 0);
+    return *this;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const value_type& v) -> iterator
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::swap(self& x) noexcept
+{
+    link_type r = root(), l = leftmost(), rm = rightmost();
+    size_type n = node_count;
+    __adopt(x.root(), x.leftmost(), x.rightmost(), x.node_count);
+    x.__adopt(r, l, rm, n);
+    std::swap(key_compare, x.key_compare);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::insert_equal(const value_type& v) -> iterator
 {
     link_type y = header;
     link_type x = root();
@@ -351,41 +770,695 @@ auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const value_t
     return __insert(x, y, v);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const value_type& v) -> std::pair<iterator, bool>
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__insert_unique_pos(const Key& k, link_type& x, link_type& y,
+                                                                         iterator& j) -> bool
 {
-    link_type y = header;
-    link_type x = root();
+    y = header;
+    x = root();
     bool comp = true;
 
     while (x != nullptr) {
         y = x;
-        comp = key_compare(KeyOfValue()(v), key(x));
+        comp = key_compare(k, key(x));
         x = comp ? left(x) : right(x);
     }
 
-    iterator j = iterator(y);
+    j = iterator(y);
     if (comp)
     {
         if (j == begin())
-            return { __insert(x, y, v), true };
+            return true;
         j--;
     }
-    if (key_compare(key(j.node), KeyOfValue()(v)))
+    return key_compare(key(j.node), k);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::insert_unique(const value_type& v) -> std::pair<iterator, bool>
+{
+    link_type x, y;
+    iterator j;
+    if (__insert_unique_pos(KeyOfValue()(v), x, y, j))
         return { __insert(x, y, v), true };
     return std::pair<iterator, bool>(j, false);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert(base_ptr x_, base_ptr y_, const Value& v) -> iterator
+// on failure the handle keeps its node
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::insert_unique(node_type&& nh) -> std::pair<iterator, bool>
+{
+    if (nh.empty())
+        return std::pair<iterator, bool>(end(), false);
+    link_type x, y;
+    iterator j;
+    if (!__insert_unique_pos(key(nh.get()), x, y, j))
+        return std::pair<iterator, bool>(j, false);
+    return { __link(x, y, nh.release()), true };
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::insert_equal(node_type&& nh) -> iterator
+{
+    if (nh.empty())
+        return end();
+    link_type y = header;
+    link_type x = root();
+    while (x != nullptr) {
+        y = x;
+        x = key_compare(key(nh.get()), key(x)) ? left(x) : right(x);
+    }
+    return __link(x, y, nh.release());
+}
+
+// moves every node of source whose key is not here yet; the rest stay
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::merge_unique(self& source)
+{
+    if (this == &source) return;
+    for (iterator i = source.begin(); i != source.end(); )
+    {
+        link_type x, y;
+        iterator j;
+        if (!__insert_unique_pos(key(i.node), x, y, j)) {
+            ++i;
+            continue;
+        }
+        iterator next = i;
+        ++next;
+        __link(x, y, source.__unlink(i));
+        i = next;
+    }
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::merge_equal(self& source)
+{
+    if (this == &source) return;
+    while (!source.empty())
+        insert_equal(source.extract(source.begin()));
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__expose(subtree t, subtree& l, subtree& r)
+{
+    int h = t.height - (t.root->get_color() == __rb_tree_black);
+    l = subtree{ left(t.root), h };
+    r = subtree{ right(t.root), h };
+    if (l.root) l.root->set_parent(nullptr);
+    if (r.root) r.root->set_parent(nullptr);
+}
+
+// l < k < r. Walks down the facing spine of the taller tree to the first
+// black node exactly as high as the shorter tree, puts k there with the
+// shorter tree as its other child and lets the insert fix-up repair a
+// red-red edge; O(difference of the heights)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__join(subtree l, link_type k, subtree r) -> subtree
+{
+    // a red root can always turn black, adding one to the height
+    if (l.root and l.root->get_color() == __rb_tree_red)
+        l.root->set_color(__rb_tree_black), l.height++;
+    if (r.root and r.root->get_color() == __rb_tree_red)
+        r.root->set_color(__rb_tree_black), r.height++;
+
+    if (l.height == r.height) {
+        k->set_parent(nullptr);
+        k->set_color(__rb_tree_black);
+        k->left = l.root;
+        k->right = r.root;
+        if (l.root) l.root->set_parent(k);
+        if (r.root) r.root->set_parent(k);
+        if (order_statistics)
+            subtree_size(k) = __rb_tree_os_size(l.root) + __rb_tree_os_size(r.root) + 1;
+        return subtree{ k, l.height + 1 };
+    }
+
+    bool right_spine = l.height > r.height;
+    subtree tall = right_spine ? l : r;
+    subtree low = right_spine ? r : l;
+    base_ptr p = nullptr;
+    base_ptr c = tall.root;
+    int h = tall.height;
+    while (c != nullptr and (c->get_color() != __rb_tree_black or h != low.height))
+    {
+        if (c->get_color() == __rb_tree_black) h--;
+        if (order_statistics) subtree_size(c) += __rb_tree_os_size(low.root) + 1;
+        p = c;
+        c = right_spine ? c->right : c->left;
+    }
+
+    if (right_spine)
+        k->left = c, k->right = low.root, p->right = k;
+    else
+        k->left = low.root, k->right = c, p->left = k;
+    k->set_parent(p);
+    if (c) c->set_parent(k);
+    if (low.root) low.root->set_parent(k);
+    if (order_statistics)
+        subtree_size(k) = __rb_tree_os_size(c) + __rb_tree_os_size(low.root) + 1;
+    base_ptr root = tall.root;
+    bool grew = __rb_tree_rebalance_insert(k, root);
+    return subtree{ (link_type)root, tall.height + grew };
+}
+
+// l < r, with no middle node: the last node of l serves as one
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__join2(subtree l, subtree r) -> subtree
+{
+    if (l.root == nullptr) return r;
+    link_type k;
+    subtree rest = __split_last(l, k);
+    return __join(rest, k, r);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__split_last(subtree t, link_type& last) -> subtree
+{
+    subtree a, b;
+    __expose(t, a, b);
+    if (b.root == nullptr) {
+        last = t.root;
+        return a;
+    }
+    subtree rest = __split_last(b, last);
+    return __join(a, t.root, rest);
+}
+
+// l gets the keys less than k and r the greater ones. An equal key goes to
+// r, unless take_equal, when the (one) node with key k is returned on its
+// own; null when there is none. If Compare throws, every level joins its
+// pieces back, so l holds all of t and r is empty
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__split(subtree t, const Key& k,
+    subtree& l, subtree& r, bool take_equal) -> link_type
+{
+    if (t.root == nullptr) {
+        l = r = subtree{ nullptr, 0 };
+        return nullptr;
+    }
+    link_type x = t.root;
+    subtree a, b;
+    __expose(t, a, b);
+    subtree* c = nullptr;   // the half split further down
+    try {
+        bool less = key_compare(k, key(x));
+        bool greater = !less and key_compare(key(x), k);
+        if (!less and !greater and take_equal) {
+            l = a, r = b;
+            return x;
+        }
+        c = greater ? &b : &a;
+        link_type found = __split(*c, k, l, r, take_equal);
+        if (greater)
+            l = __join(a, x, l);
+        else
+            r = __join(r, x, b);
+        return found;
+    }
+    catch (...) {
+        // the level below has put all of *c back into l
+        if (c) *c = l;
+        l = __join(a, x, b);
+        r = subtree{ nullptr, 0 };
+        throw;
+    }
+}
+
+// l gets the nodes in front of pos and r gets pos and the rest; no keys
+// are compared, the path down to pos decides
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__split_at(subtree t, link_type pos,
+    subtree& l, subtree& r)
+{
+    // a red-black tree of n nodes is at most 2 log(n + 1) high
+    link_type path[2 * CHAR_BIT * sizeof(size_type) + 1];
+    int depth = 0;
+    for (link_type x = pos; x != nullptr; x = parent(x))
+        depth++;
+    path[depth] = nullptr;
+    for (link_type x = pos; x != nullptr; x = parent(x))
+        path[--depth] = x;
+    __split_at(t, path, l, r);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__split_at(subtree t, link_type* path,
+    subtree& l, subtree& r)
+{
+    link_type x = t.root;
+    subtree a, b;
+    __expose(t, a, b);
+    if (path[1] == nullptr) {
+        l = a;
+        r = __join(subtree{ nullptr, 0 }, x, b);
+    }
+    else if (path[1] == a.root) {
+        __split_at(a, path + 1, l, r);
+        r = __join(r, x, b);
+    }
+    else {
+        __split_at(b, path + 1, l, r);
+        l = __join(a, x, l);
+    }
+}
+
+// runs both tasks, handing the second to the task pool when fork is set.
+// Neither throws: an exception from a task is caught into e1 or e2
+template <typename Task1, typename Task2>
+void __rb_tree_parallel_invoke(bool fork, Task1 t1, Task2 t2, std::exception_ptr& e1, std::exception_ptr& e2)
+{
+    struct pooled : __pool_task {
+        Task2* f;
+        std::exception_ptr* e;
+        static void call(__pool_task* p) {
+            pooled* self = static_cast<pooled*>(p);
+            try {
+                (*self->f)();
+            }
+            catch (...) {
+                *self->e = std::current_exception();
+            }
+        }
+    };
+    pooled task;
+    task.run = &pooled::call;
+    task.f = &t2;
+    task.e = &e2;
+    __task_pool* pool = fork ? &__global_task_pool() : nullptr;
+    if (pool and pool->size() == 0) pool = nullptr;
+    if (pool) pool->submit(&task);
+    try {
+        t1();
+    }
+    catch (...) {
+        e1 = std::current_exception();
+    }
+    if (pool)
+        pool->wait(&task);
+    else
+        pooled::call(&task);
+}
+
+// in the three set operations below a is split around the root of b, the
+// halves are combined recursively and joined back around that root
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__step_split(subtree& a, subtree& b, step& s)
+{
+    s.x = b.root;
+    __expose(b, s.bl, s.br);
+    try {
+        s.dup = __split(a, key(s.x), s.al, s.ar, true);
+    }
+    catch (...) {
+        // __split has put all of a back into al
+        a = s.al;
+        b = __join(s.bl, s.x, s.br);
+        throw;
+    }
+}
+
+// a failed half hands its pieces back in its al/ar and bl/br; the a side
+// then gets the finished results and those pieces around dup, the b side
+// the rest of b around x
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__step_recurse(set_operation op,
+    subtree& a, subtree& b, step& s, garbage& g, int depth)
+{
+    garbage gr;
+    std::exception_ptr el, er;
+    __rb_tree_parallel_invoke(depth > 0 and std::min(a.height, b.height) >= parallel_height,
+        [&] { s.l = (this->*op)(s.al, s.bl, g, depth - 1); },
+        [&] { s.r = (this->*op)(s.ar, s.br, gr, depth - 1); }, el, er);
+    g.splice(gr);
+    if (el or er) {
+        if (el) s.l = s.al;
+        else s.bl = subtree{ nullptr, 0 };
+        if (er) s.r = s.ar;
+        else s.br = subtree{ nullptr, 0 };
+        a = s.dup ? __join(s.l, s.dup, s.r) : __join2(s.l, s.r);
+        b = __join(s.bl, s.x, s.br);
+        std::rethrow_exception(el ? el : er);
+    }
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__union(subtree& a, subtree& b,
+    garbage& g, int depth) -> subtree
+{
+    if (a.root == nullptr) return b;
+    if (b.root == nullptr) return a;
+    step s;
+    __step_split(a, b, s);
+    __step_recurse(&rb_tree::__union, a, b, s, g, depth);
+    if (s.dup) g.push(s.dup);
+    return __join(s.l, s.x, s.r);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__intersection(subtree& a, subtree& b,
+    garbage& g, int depth) -> subtree
+{
+    if (a.root == nullptr or b.root == nullptr) {
+        __collect(a.root, g);
+        __collect(b.root, g);
+        return subtree{ nullptr, 0 };
+    }
+    step s;
+    __step_split(a, b, s);
+    __step_recurse(&rb_tree::__intersection, a, b, s, g, depth);
+    if (s.dup) {
+        g.push(s.dup);
+        return __join(s.l, s.x, s.r);
+    }
+    g.push(s.x);
+    return __join2(s.l, s.r);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__difference(subtree& a, subtree& b,
+    garbage& g, int depth) -> subtree
+{
+    if (a.root == nullptr or b.root == nullptr) {
+        __collect(b.root, g);
+        return a;
+    }
+    step s;
+    __step_split(a, b, s);
+    __step_recurse(&rb_tree::__difference, a, b, s, g, depth);
+    g.push(s.x);
+    if (s.dup) g.push(s.dup);
+    return __join2(s.l, s.r);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__collect(link_type x, garbage& g)
+{
+    while (x != nullptr) {
+        __collect(left(x), g);
+        link_type r = right(x);
+        g.push(x);
+        x = r;
+    }
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__count_upto(link_type x, size_type limit) -> size_type
+{
+    size_type n = 0;
+    for (; x != nullptr and n < limit; x = right(x))
+        n += __count_upto(left(x), limit - n) + 1;
+    return n;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+int rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__parallel_depth()
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    int depth = 0;
+    while ((1u << depth) < threads)
+        depth++;
+    return depth;
+}
+
+// takes the whole tree off the header, leaving *this empty
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__release() -> subtree
+{
+    subtree t{ root(), 0 };
+    for (link_type x = t.root; x != nullptr; x = left(x))
+        t.height += x->get_color() == __rb_tree_black;
+    if (t.root) t.root->set_parent(nullptr);
+    __adopt(nullptr, nullptr, nullptr, 0);
+    return t;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__free(garbage& g)
+{
+    while (g.head != nullptr) {
+        link_type next = right(g.head);
+        destroy_node(g.head);
+        g.head = next;
+    }
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::split(const Key& k, self& right)
+{
+    if (this == &right) return;
+    right.clear();
+    size_type n = node_count;
+    subtree l, r;
+    try {
+        __split(__release(), k, l, r, false);
+    }
+    catch (...) {
+        // l holds the whole tree again
+        __adopt(l, n);
+        throw;
+    }
+
+    size_type nl;
+    if (order_statistics)
+        nl = __rb_tree_os_size(l.root);
+    else {
+        // count whichever half runs out first
+        for (size_type limit = 64; ; limit *= 2) {
+            if ((nl = __count_upto(l.root, limit)) < limit)
+                break;
+            size_type nr = __count_upto(r.root, limit);
+            if (nr < limit) {
+                nl = n - nr;
+                break;
+            }
+        }
+    }
+    __adopt(l, nl);
+    right.__adopt(r, n - nl);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::join(self& right)
+{
+    if (this == &right or right.empty()) return;
+    if (empty()) {
+        swap(right);
+        return;
+    }
+    size_type n = node_count + right.node_count;
+    link_type k = right.__unlink(right.begin());
+    subtree r = right.__release();
+    __adopt(__join(__release(), k, r), n);
+}
+
+// *this gets the result and x is left empty. If Compare throws, the nodes
+// not yet dropped stay with *this (the a side) and x (the b side)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__set_operation(set_operation op,
+    self& x, bool this_first)
+{
+    size_type n = node_count + x.node_count;
+    garbage g;
+    subtree a = this_first ? __release() : x.__release();
+    subtree b = this_first ? x.__release() : __release();
+    subtree t;
+    try {
+        t = (this->*op)(a, b, g, __parallel_depth());
+    }
+    catch (...) {
+        __free(g);
+        __adopt(a, __subtree_count(a));
+        x.__adopt(b, __subtree_count(b));
+        throw;
+    }
+    __adopt(t, n - g.count);
+    __free(g);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::set_union(self& x)
+{
+    if (this == &x) return;
+    __set_operation(&rb_tree::__union, x, false);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::set_intersection(self& x)
+{
+    if (this == &x) return;
+    __set_operation(&rb_tree::__intersection, x, false);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::set_difference(self& x)
+{
+    if (this == &x) {
+        clear();
+        return;
+    }
+    __set_operation(&rb_tree::__difference, x, true);
+}
+
+// a hint is right when v belongs just before it; then the node is linked
+// next to the hint without descending from the root, otherwise it falls back
+// to the plain insert. __insert() takes a non-null x to mean "left of y"
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::insert_unique(iterator position, const value_type& v) -> iterator
+{
+    if (position.node == header->left)
+    {
+        if (node_count > 0 and key_compare(KeyOfValue()(v), key(position.node)))
+            return __insert(position.node, position.node, v);
+        return insert_unique(v).first;
+    }
+    if (position.node == header)
+    {
+        if (key_compare(key(rightmost()), KeyOfValue()(v)))
+            return __insert(nullptr, rightmost(), v);
+        return insert_unique(v).first;
+    }
+    iterator before = position;
+    --before;
+    if (key_compare(key(before.node), KeyOfValue()(v)) and
+        key_compare(KeyOfValue()(v), key(position.node)))
+    {
+        if (right(before.node) == nullptr)
+            return __insert(nullptr, before.node, v);
+        return __insert(position.node, position.node, v);
+    }
+    return insert_unique(v).first;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::insert_equal(iterator position, const value_type& v) -> iterator
+{
+    if (position.node == header->left)
+    {
+        if (node_count > 0 and !key_compare(key(position.node), KeyOfValue()(v)))
+            return __insert(position.node, position.node, v);
+        return insert_equal(v);
+    }
+    if (position.node == header)
+    {
+        if (!key_compare(KeyOfValue()(v), key(rightmost())))
+            return __insert(nullptr, rightmost(), v);
+        return insert_equal(v);
+    }
+    iterator before = position;
+    --before;
+    if (!key_compare(KeyOfValue()(v), key(before.node)) and
+        !key_compare(key(position.node), KeyOfValue()(v)))
+    {
+        if (right(before.node) == nullptr)
+            return __insert(nullptr, before.node, v);
+        return __insert(position.node, position.node, v);
+    }
+    return insert_equal(v);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename InputIterator>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__insert_range(InputIterator first, InputIterator last,
+                                                                    bool unique, input_iterator_tag)
+{
+    for (; first != last; ++first)
+        unique ? (void)insert_unique(end(), *first) : (void)insert_equal(end(), *first);
+}
+
+// an empty tree filled from a sorted forward range is built directly in O(n);
+// one pass checks the order and counts the nodes (adjacent equal keys collapse
+// for insert_unique), anything else goes element by element
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename ForwardIterator>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__insert_range(ForwardIterator first, ForwardIterator last,
+                                                                    bool unique, forward_iterator_tag)
+{
+    if (node_count != 0 or first == last) {
+        __insert_range(first, last, unique, input_iterator_tag());
+        return;
+    }
+
+    size_type n = 1;
+    ForwardIterator prev = first;
+    ForwardIterator cur = first;
+    for (++cur; cur != last; prev = cur, ++cur)
+    {
+        const value_type& a = *prev;
+        const value_type& b = *cur;
+        if (key_compare(KeyOfValue()(b), KeyOfValue()(a))) {
+            __insert_range(first, last, unique, input_iterator_tag());
+            return;
+        }
+        if (!unique or key_compare(KeyOfValue()(a), KeyOfValue()(b)))
+            n++;
+    }
+
+    // every level is full except possibly the deepest one, whose nodes are
+    // red so that all paths keep the same number of black nodes
+    int depth = 0;
+    while ((size_type(2) << depth) <= n) depth++;
+    int red_depth = (n & (n + 1)) == 0 ? -1 : depth;
+
+    link_type r = __build_sorted(first, last, n, unique, 0, red_depth);
+    r->set_parent(header);
+    root() = r;
+    leftmost() = minimum(r);
+    rightmost() = maximum(r);
+    r->set_color(__rb_tree_black);
+    node_count = n;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename ForwardIterator>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__build_sorted(ForwardIterator& first, ForwardIterator last,
+                                                                    size_type n, bool unique,
+                                                                    int depth, int red_depth) -> link_type
+{
+    if (n == 0) return nullptr;
+
+    size_type left_n = (n - 1) / 2;
+    link_type l = __build_sorted(first, last, left_n, unique, depth + 1, red_depth);
+    link_type x;
+    try {
+        x = create_node(*first);
+    }
+    catch (...) {
+        __erase(l);
+        throw;
+    }
+    x->set_parent_color(nullptr, depth == red_depth ? __rb_tree_red : __rb_tree_black);
+    left(x) = l;
+    right(x) = nullptr;
+    if (l != nullptr) l->set_parent(x);
+    if (order_statistics) subtree_size(x) = n;
+
+    ++first;
+    for (; unique and first != last; ++first) {
+        const value_type& v = *first;
+        if (key_compare(key(x), KeyOfValue()(v))) break;
+    }
+
+    try {
+        right(x) = __build_sorted(first, last, n - 1 - left_n, unique, depth + 1, red_depth);
+    }
+    catch (...) {
+        __erase(x);
+        throw;
+    }
+    if (right(x) != nullptr) right(x)->set_parent(x);
+    return x;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__link(base_ptr x_, base_ptr y_, link_type z) -> iterator
 {
     link_type x = (link_type)x_;
     link_type y = (link_type)y_;
-    link_type z;
 
-    if (y == header or x != nullptr or key_compare(KeyOfValue()(v), key(y)))
+    if (y == header or x != nullptr or key_compare(key(z), key(y)))
     {
-        z = create_node(v);
         left(y) = z;
         if (y == header) {
             root() = z;
@@ -396,141 +1469,124 @@ auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert(base_ptr x_, base
     }
     else
     {
-        z = create_node(v);
         right(y) = z;
+        if (y == rightmost())
+            rightmost() = z;
     }
 
-    parent(z) = y;
+    z->set_parent_color(y, __rb_tree_red);
     left(z) = nullptr;
     right(z) = nullptr;
-    __rb_tree_rebalance_insert(z, header->parent);
+    if (order_statistics) {
+        subtree_size(z) = 1;
+        for (base_ptr p = y; p != header; p = p->get_parent())
+            subtree_size(p)++;
+    }
+    __rb_tree_rebalance_insert(z, header->root_slot());
     node_count++;
     return iterator(z);
 }
 
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rb_tree_rebalance_insert(base_ptr x, base_ptr& root)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+bool rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__rb_tree_rebalance_insert(base_ptr x, base_ptr& root)
 {
-    x->color = __rb_tree_red;
-    while (x != root and x->parent->color == __rb_tree_red)
+    x->set_color(__rb_tree_red);
+    while (x != root and x->get_parent()->get_color() == __rb_tree_red)
     {
-        if (x->parent == x->parent->parent->left)
+        if (x->get_parent() == x->get_parent()->get_parent()->left)
         {
-            base_ptr y = x->parent->parent->right;
-            if (y and y->color == __rb_tree_red) {
-                x->parent->color = __rb_tree_black;
-                y->color = __rb_tree_black;
-                x->parent->parent->color = __rb_tree_red;
-                x = x->parent->parent;
+            base_ptr y = x->get_parent()->get_parent()->right;
+            if (y and y->get_color() == __rb_tree_red) {
+                x->get_parent()->set_color(__rb_tree_black);
+                y->set_color(__rb_tree_black);
+                x->get_parent()->get_parent()->set_color(__rb_tree_red);
+                x = x->get_parent()->get_parent();
             }
             else {
-                if (x == x->parent->right) {
-                    x = x->parent;
+                if (x == x->get_parent()->right) {
+                    x = x->get_parent();
                     __rb_tree_rotate_left(x, root);
                 }
-                x->parent->color = __rb_tree_black;
-                x->parent->parent->color = __rb_tree_red;
-                __rb_tree_rotate_right(x->parent->parent, root);
+                x->get_parent()->set_color(__rb_tree_black);
+                x->get_parent()->get_parent()->set_color(__rb_tree_red);
+                __rb_tree_rotate_right(x->get_parent()->get_parent(), root);
             }
         }
         else
         {
-            base_ptr y = x->parent->parent->left;
-            if (y and y->color == __rb_tree_red) {
-                x->parent->color = __rb_tree_black;
-                y->color = __rb_tree_black;
-                x->parent->parent->color = __rb_tree_red;
-                x = x->parent->parent;
+            base_ptr y = x->get_parent()->get_parent()->left;
+            if (y and y->get_color() == __rb_tree_red) {
+                x->get_parent()->set_color(__rb_tree_black);
+                y->set_color(__rb_tree_black);
+                x->get_parent()->get_parent()->set_color(__rb_tree_red);
+                x = x->get_parent()->get_parent();
             }
             else {
-                if (x == x->parent->left) {
-                    x = x->parent;
+                if (x == x->get_parent()->left) {
+                    x = x->get_parent();
                     __rb_tree_rotate_right(x, root);
                 }
-                x->parent->color = __rb_tree_black;
-                x->parent->parent->color = __rb_tree_red;
-                __rb_tree_rotate_left(x->parent->parent, root);
+                x->get_parent()->set_color(__rb_tree_black);
+                x->get_parent()->get_parent()->set_color(__rb_tree_red);
+                __rb_tree_rotate_left(x->get_parent()->get_parent(), root);
             }
         }
     }
-    root->color = __rb_tree_black;
+    // a red root turned black means every path gained a black node
+    bool grew = root->get_color() == __rb_tree_red;
+    root->set_color(__rb_tree_black);
+    return grew;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rb_tree_rotate_left(base_ptr x, base_ptr& root)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__rb_tree_rotate_left(base_ptr x, base_ptr& root)
 {
     base_ptr y = x->right;
     x->right = y->left;
     if (y->left != nullptr)
-        y->left->parent = x;
-    y->parent = x->parent;
+        y->left->set_parent(x);
+    y->set_parent(x->get_parent());
 
     if (x == root)
         root = y;
-    else if (x == x->parent->left)
-        x->parent->left = y;
+    else if (x == x->get_parent()->left)
+        x->get_parent()->left = y;
     else
-        x->parent->right = y;
+        x->get_parent()->right = y;
     y->left = x;
-    x->parent = y;
+    x->set_parent(y);
+    if (order_statistics) {
+        subtree_size(y) = subtree_size(x);
+        subtree_size(x) = __rb_tree_os_size(x->left) + __rb_tree_os_size(x->right) + 1;
+    }
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rb_tree_rotate_right(base_ptr x, base_ptr& root)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__rb_tree_rotate_right(base_ptr x, base_ptr& root)
 {
     base_ptr y = x->left;
     x->left = y->right;
     if (y->right != nullptr)
-        y->right->parent = x;
-    y->parent = x->parent;
+        y->right->set_parent(x);
+    y->set_parent(x->get_parent());
 
     if (x == root)
         root = y;
-    else if (x == x->parent->right)
-        x->parent->right = y;
+    else if (x == x->get_parent()->right)
+        x->get_parent()->right = y;
     else
-        x->parent->left = y;
+        x->get_parent()->left = y;
     y->right = x;
-    x->parent = y;
-}
-
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::find(const Key& k) -> iterator
-{
-    link_type y = header;
-    link_type x = root();
-
-    while (x != nullptr)
-    {
-        if (!key_compare(key(x), k))
-            y = x, x = left(x);
-        else
-            x = right(x);
+    x->set_parent(y);
+    if (order_statistics) {
+        subtree_size(y) = subtree_size(x);
+        subtree_size(x) = __rb_tree_os_size(x->left) + __rb_tree_os_size(x->right) + 1;
     }
-    iterator j = iterator(y);
-    return (j == end() or key_compare(k, key(j.node)) ? end() : j);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::find(const Key& k) const -> const_iterator
-{
-    link_type y = header;
-    link_type x = root();
-
-    while (x != nullptr)
-    {
-        if (!key_compare(key(x), k))
-            y = x, x = left(x);
-        else
-            x = right(x);
-    }
-    iterator j = const_iterator(y);
-    return (j == end() or key_compare(k, key(j.node)) ? end() : j);
-}
-
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__erase(link_type x)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__erase(link_type x)
 {
     if (x == nullptr) return;
     __erase(left(x));
@@ -538,37 +1594,57 @@ void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__erase(link_type x)
     destroy_node(x);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::clear()
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::clear()
 {
     __erase(root());
     left(header) = header;
     right(header) = header;
-    parent(header) = nullptr;
+    root() = nullptr;
+    node_count = 0;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase(iterator position)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::erase(iterator position)
 {
 	base_ptr to_be_delete = __rb_tree_rebalance_erase(position.node, (base_ptr&)root());
 	destroy_node((link_type)to_be_delete);
 	node_count--;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase(const Key& val) -> size_type
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::erase(const Key& val) -> size_type
 {
-	iterator first = lower_bound(val);
-    iterator last = upper_bound(val);
-    size_type len = distance(first, last);
+    std::pair<link_type, link_type> range = __equal_range(val);
+    iterator first = range.first, last = range.second;
+    size_type len = 0;
+    for (iterator i = first; i != last and len < erase_split_threshold; ++i)
+        len++;
+    if (len < erase_split_threshold) {
+        while (first != last)
+            erase(first++);
+        return len;
+    }
 
-    while (first != last)
-        erase(first++);
+    // cut the run out between two splits and join the ends, so the tree
+    // is rebuilt along O(log n) nodes however long the run is
+    size_type n = node_count;
+    subtree l, m, r;
+    __split_at(__release(), range.first, l, m);
+    if (range.second != header)
+        __split_at(m, range.second, m, r);
+    else
+        r = subtree{ nullptr, 0 };
+    garbage g;
+    __collect(m.root, g);
+    __adopt(__join2(l, r), n - g.count);
+    len = g.count;
+    __free(g);
     return len;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rb_tree_rebalance_erase(base_ptr z, base_ptr& root) -> base_ptr
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__rb_tree_rebalance_erase(base_ptr z, base_ptr& root) -> base_ptr
 {
 	base_ptr del_node = z;
 	base_ptr replace_node = nullptr;
@@ -588,28 +1664,28 @@ auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rb_tree_rebalance_erase(
 
 	if (del_node == z)
 	{
-		replace_node_parent = del_node->parent;
+		replace_node_parent = del_node->get_parent();
 		if (z == root)
 			root = replace_node;
-		else if (z == z->parent->left)
-			z->parent->left = replace_node;
+		else if (z == z->get_parent()->left)
+			z->get_parent()->left = replace_node;
 		else
-			z->parent->right = replace_node;
+			z->get_parent()->right = replace_node;
 
 		if (replace_node != nullptr)
-            replace_node->parent = z->parent;
+            replace_node->set_parent(z->get_parent());
         
         if (z == leftmost())
 		{
 			if (z->right == nullptr)
-				leftmost() = (link_type)z->parent;
+				leftmost() = (link_type)z->get_parent();
 			else
 				leftmost() = minimum((link_type)replace_node);
 		}
 		if (z == rightmost())
 		{
 			if (z->left == 0)
-				rightmost() = (link_type)z->parent;
+				rightmost() = (link_type)z->get_parent();
 			else
 				rightmost() = maximum((link_type)replace_node);
 		}
@@ -617,69 +1693,76 @@ auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rb_tree_rebalance_erase(
 	else
 	{
 		del_node->left = z->left;
-		z->left->parent = del_node;
+		z->left->set_parent(del_node);
 
 		if (z->right != del_node)
 		{
-			replace_node_parent = del_node->parent;
+			replace_node_parent = del_node->get_parent();
 			if (replace_node != nullptr) 
-				replace_node->parent = del_node->parent;
-			del_node->parent->left = replace_node;
+				replace_node->set_parent(del_node->get_parent());
+			del_node->get_parent()->left = replace_node;
 
 			del_node->right = z->right;
-			z->right->parent = del_node;
+			z->right->set_parent(del_node);
 		}
 		else
 			replace_node_parent = del_node;
 
 		if (z == root)
 			root = del_node;
-		else if (z == z->parent->left)
-			z->parent->left = del_node;
+		else if (z == z->get_parent()->left)
+			z->get_parent()->left = del_node;
 		else
-			z->parent->right = del_node;
-		del_node->parent = z->parent;
-
-		std::swap(del_node->color, z->color);
+			z->get_parent()->right = del_node;
+		del_node->set_parent(z->get_parent());
+
+		color_type c = del_node->get_color();
+		del_node->set_color(z->get_color());
+		z->set_color(c);
+		if (order_statistics)
+			subtree_size(del_node) = subtree_size(z);
 		del_node = z;	
 	}
-    if (del_node->color == __rb_tree_red)
+	if (order_statistics)
+		for (base_ptr p = replace_node_parent; p != header; p = p->get_parent())
+			subtree_size(p)--;
+    if (del_node->get_color() == __rb_tree_red)
         return del_node;
 
-	while (replace_node != root and (!replace_node or replace_node->color == __rb_tree_black))  
+	while (replace_node != root and (!replace_node or replace_node->get_color() == __rb_tree_black))  
 	{
 		if (replace_node == replace_node_parent->left)
 		{
 			base_ptr s = replace_node_parent->right;
-			if (s->color == __rb_tree_red)
+			if (s->get_color() == __rb_tree_red)
 			{
-				s->color = __rb_tree_black;
-				replace_node_parent->color = __rb_tree_red;
+				s->set_color(__rb_tree_black);
+				replace_node_parent->set_color(__rb_tree_red);
 				__rb_tree_rotate_left(replace_node_parent, root);
 				s = replace_node_parent->right;
 			}
-			if ((!s->left or s->left->color == __rb_tree_black) and
-				(!s->right or s->right->color == __rb_tree_black))
+			if ((!s->left or s->left->get_color() == __rb_tree_black) and
+				(!s->right or s->right->get_color() == __rb_tree_black))
 			{
-				s->color = __rb_tree_red;
+				s->set_color(__rb_tree_red);
 				replace_node = replace_node_parent;
-				replace_node_parent = replace_node_parent->parent;
+				replace_node_parent = replace_node_parent->get_parent();
 			}
 			else
 			{
-				if (!s->right or s->right->color == __rb_tree_black)
+				if (!s->right or s->right->get_color() == __rb_tree_black)
 				{
 					if (s->left != nullptr)
-						s->left->color = __rb_tree_black;
-					s->right->color = __rb_tree_red;
+						s->left->set_color(__rb_tree_black);
+					s->set_color(__rb_tree_red);
                     __rb_tree_rotate_right(s, root);
 					s = replace_node_parent->right;
 				}
 
-				s->color = replace_node_parent->color;
-				replace_node_parent->color = __rb_tree_black;
+				s->set_color(replace_node_parent->get_color());
+				replace_node_parent->set_color(__rb_tree_black);
 				if (s->right != nullptr)
-					s->right->color = __rb_tree_black;
+					s->right->set_color(__rb_tree_black);
 				__rb_tree_rotate_left(replace_node_parent, root);
 				break;
 			}
@@ -687,119 +1770,256 @@ auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__rb_tree_rebalance_erase(
 		else
 		{
 			base_ptr s = replace_node_parent->left;
-			if (s->color == __rb_tree_red)
+			if (s->get_color() == __rb_tree_red)
 			{
-				s->color = __rb_tree_black;
-				replace_node_parent->color = __rb_tree_red;
+				s->set_color(__rb_tree_black);
+				replace_node_parent->set_color(__rb_tree_red);
 				__rb_tree_rotate_right(replace_node_parent, root);
 				s = replace_node_parent->left;
 			}
 
-			if ((!s->left or s->left->color == __rb_tree_black) and
-				(!s->right or s->right->color == __rb_tree_black))
+			if ((!s->left or s->left->get_color() == __rb_tree_black) and
+				(!s->right or s->right->get_color() == __rb_tree_black))
 			{
-				s->color = __rb_tree_red;
+				s->set_color(__rb_tree_red);
 				replace_node = replace_node_parent;
-				replace_node_parent = replace_node_parent->parent;
+				replace_node_parent = replace_node_parent->get_parent();
 			}
 			else
 			{
-				if (!s->left or s->left->color == __rb_tree_black)
+				if (!s->left or s->left->get_color() == __rb_tree_black)
 				{
 					if (s->right != nullptr)
-						s->right->color = __rb_tree_black;
-					s->color = __rb_tree_red;
+						s->right->set_color(__rb_tree_black);
+					s->set_color(__rb_tree_red);
 					__rb_tree_rotate_left(s, root);
 					s = replace_node_parent->left;
 				}
-				s->color = replace_node_parent->color;
-				replace_node_parent->color = __rb_tree_black;
+				s->set_color(replace_node_parent->get_color());
+				replace_node_parent->set_color(__rb_tree_black);
 				if (s->left != nullptr)
-					s->left->color = __rb_tree_black;
+					s->left->set_color(__rb_tree_black);
 				__rb_tree_rotate_right(replace_node_parent, root);
 			    break;
 			}
 		}
 	}
 	if (replace_node != nullptr) 
-        replace_node->color = __rb_tree_black;
+        replace_node->set_color(__rb_tree_black);
 	return del_node;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::count(const key_type& k) const -> size_type
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename K>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__count(const K& k) const -> size_type
 {
-    const_iterator first = lower_bound(k);
-    const_iterator last = upper_bound(k);
-    return distance(first, last);
+    if (!order_statistics) {
+        std::pair<link_type, link_type> range = __equal_range(k);
+        return Tiny::distance(const_iterator(range.first), const_iterator(range.second));
+    }
+    // from the first node with key k, add up the subtrees on either side
+    // that hold k without visiting them
+    link_type x = root();
+    while (x != nullptr)
+    {
+        if (key_compare(key(x), k))
+            x = right(x);
+        else if (key_compare(k, key(x)))
+            x = left(x);
+        else {
+            size_type n = 1;
+            for (link_type y = left(x); y != nullptr; )
+                if (key_compare(key(y), k))
+                    y = right(y);
+                else
+                    n += __rb_tree_os_size(y->right) + 1, y = left(y);
+            for (link_type y = right(x); y != nullptr; )
+                if (key_compare(k, key(y)))
+                    y = left(y);
+                else
+                    n += __rb_tree_os_size(y->left) + 1, y = right(y);
+            return n;
+        }
+    }
+    return 0;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::lower_bound(const Key& k) -> iterator
+// one descent to the first node with key k, then the two bounds in the
+// subtrees below it
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename K>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__equal_range(const K& k) const
+    -> std::pair<link_type, link_type>
 {
     link_type y = header;
     link_type x = root();
-
-    while (x != nullptr) 
+    while (x != nullptr)
     {
-        if (!key_compare(key(x), k))
+        if (key_compare(key(x), k))
+            x = right(x);
+        else if (key_compare(k, key(x)))
             y = x, x = left(x);
         else
-            x = right(x);
+            return std::pair<link_type, link_type>(__lower_bound(left(x), x, k), __upper_bound(right(x), y, k));
     }
+    return std::pair<link_type, link_type>(y, y);
+}
 
-    return iterator(y);
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename K>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__find(const K& k) const -> link_type
+{
+    link_type y = __lower_bound(k);
+    return (y == header or key_compare(k, key(y))) ? header : y;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::lower_bound(const Key& k) const -> const_iterator
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename K>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__lower_bound(link_type x, link_type y,
+    const K& k) const -> link_type
 {
-    link_type y = header;
-    link_type x = root();
+    // both successors are already known, so the next load does not wait
+    // for the comparison, and the selects below compile to moves
+    while (x != nullptr) 
+    {
+        __RB_TREE_PREFETCH(x->left);
+        __RB_TREE_PREFETCH(x->right);
+        bool go_left = !key_compare(key(x), k);
+        y = go_left ? x : y;
+        x = go_left ? left(x) : right(x);
+    }
 
+    return y;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename K>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__upper_bound(link_type x, link_type y,
+    const K& k) const -> link_type
+{
     while (x != nullptr) 
     {
-        if (!key_compare(key(x), k))
-            y = x, x = left(x);
-        else
-            x = right(x);
+        __RB_TREE_PREFETCH(x->left);
+        __RB_TREE_PREFETCH(x->right);
+        bool go_left = key_compare(k, key(x));
+        y = go_left ? x : y;
+        x = go_left ? left(x) : right(x);
     }
 
-    return const_iterator(y);
+    return y;
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::upper_bound(const Key& k) -> iterator
+// runs up to find_many_lanes lower_bound descents side by side, one level
+// of each per round, so the cache misses of different keys overlap
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+template <typename Iterator, typename ForwardIterator, typename OutputIterator>
+OutputIterator rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__find_many(ForwardIterator first,
+    ForwardIterator last, OutputIterator out) const
 {
-    link_type y = header;
-    link_type x = root();
+    ForwardIterator keys[find_many_lanes];
+    link_type x[find_many_lanes];
+    link_type y[find_many_lanes];
+    while (first != last)
+    {
+        int n = 0;
+        for (; n < find_many_lanes and first != last; n++, ++first) {
+            keys[n] = first;
+            x[n] = root();
+            y[n] = header;
+        }
+        for (bool active = true; active; )
+        {
+            active = false;
+            for (int i = 0; i < n; i++)
+            {
+                link_type cur = x[i];
+                if (cur == nullptr) continue;
+                __RB_TREE_PREFETCH(cur->left);
+                __RB_TREE_PREFETCH(cur->right);
+                bool go_left = !key_compare(key(cur), *keys[i]);
+                y[i] = go_left ? cur : y[i];
+                x[i] = go_left ? left(cur) : right(cur);
+                active = true;
+            }
+        }
+        for (int i = 0; i < n; i++, ++out)
+            *out = Iterator(y[i] == header or key_compare(*keys[i], key(y[i])) ? header : y[i]);
+    }
+    return out;
+}
 
-    while (x != 0) 
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::select(size_type k) -> iterator
+{
+    static_assert(order_statistics, "select() needs NodeBase = order_statistics");
+    link_type x = root();
+    while (x != nullptr)
     {
-        if (key_compare(k, key(x)))
-            y = x, x = left(x);
+        size_type l = __rb_tree_os_size(x->left);
+        if (k < l)
+            x = left(x);
+        else if (k == l)
+            return iterator(x);
         else
-            x = right(x);
+            k -= l + 1, x = right(x);
     }
+    return end();
+}
 
-   return iterator(y);
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::select(size_type k) const -> const_iterator
+{
+    return const_cast<rb_tree*>(this)->select(k);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::upper_bound(const Key& k) const -> const_iterator
+// number of elements less than k, i.e. the position of lower_bound(k)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+auto rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::rank(const Key& k) const -> size_type
 {
-    link_type y = header;
+    static_assert(order_statistics, "rank() needs NodeBase = order_statistics");
+    size_type r = 0;
     link_type x = root();
-
-    while (x != 0)
-    { 
-        if (key_compare(k, key(x)))
-            y = x, x = left(x);
+    while (x != nullptr)
+    {
+        if (!key_compare(key(x), k))
+            x = left(x);
         else
-            x = right(x);
+            r += __rb_tree_os_size(x->left) + 1, x = right(x);
     }
+    return r;
+}
 
-    return const_iterator(y);
+// checks order, colors, black heights, parent links, the size and the
+// leftmost/rightmost cache; for tests
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeBase>
+bool rb_tree<Key, Value, KeyOfValue, Compare, Alloc, NodeBase>::__rb_verify() const
+{
+    if (node_count == 0 or root() == nullptr)
+        return node_count == 0 and root() == nullptr and
+               leftmost() == header and rightmost() == header;
+    if (root()->get_color() != __rb_tree_black or root()->get_parent() != header)
+        return false;
+
+    int len = __black_count(leftmost(), root());
+    size_type n = 0;
+    for (const_iterator it = begin(); it != end(); ++it, ++n)
+    {
+        link_type x = (link_type)it.node;
+        link_type l = left(x);
+        link_type r = right(x);
+        if (x->get_color() == __rb_tree_red)
+            if ((l and l->get_color() == __rb_tree_red) or (r and r->get_color() == __rb_tree_red))
+                return false;
+        if (l and (l->get_parent() != x or key_compare(key(x), key(l)))) return false;
+        if (r and (r->get_parent() != x or key_compare(key(r), key(x)))) return false;
+        if ((!l or !r) and __black_count(x, root()) != len) return false;
+        if (order_statistics and
+            subtree_size(x) != __rb_tree_os_size(l) + __rb_tree_os_size(r) + 1) return false;
+    }
+    if (n != node_count) return false;
+    if (leftmost() != minimum(root())) return false;
+    if (rightmost() != maximum(root())) return false;
+    return true;
 }
 
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstring>              // for memmove()
+#include <utility>              // for move_if_noexcept()
 #include "tiny_construct.h"     // for construct(), destroy()
 #include "tiny_type_traits.h"   // for __type_traits, __true_type, __false_type
 #include "tiny_iterator.h"
@@ -87,6 +88,47 @@ wchar_t* uninitialized_copy(const wchar_t* first, const wchar_t* last, wchar_t*
     return result + (last - first);
 }
 
+// function uninitialized_move_if_noexcept()
+// moves when the move constructor cannot throw (or there is no copy), copies
+// otherwise, so a failure part way leaves the source range intact
+
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator __uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last, ForwardIterator result, __true_type)
+{
+    return std::copy(first, last, result);
+}
+
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator __uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type)
+{
+    ForwardIterator cur = result;
+    try {
+        for (; first != last; first++) {
+            construct(&*cur, std::move_if_noexcept(*first));
+            cur++;
+        }
+    }
+    catch (...) {
+        for (; result != cur; result++)
+            destroy(&*result);
+        throw;
+    }
+    return cur;
+}
+
+template <typename InputIterator, typename ForwardIterator, typename T>
+ForwardIterator __uninitialized_move_if_noexcept(InputIterator first, InputIterator last, ForwardIterator result, T*)
+{
+    using is_POD = typename __type_traits<T>::is_POD_type;
+    return __uninitialized_move_if_noexcept_aux(first, last, result, is_POD());
+}
+
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator uninitialized_move_if_noexcept(InputIterator first, InputIterator last, ForwardIterator result)
+{
+    return __uninitialized_move_if_noexcept(first, last, result, value_type(result));
+}
+
 // function uninitialized_fill()
 
 template <typename ForwardIterator, typename T>
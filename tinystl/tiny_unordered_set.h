@@ -56,12 +56,25 @@ public:
     size_type count(const key_type& key) const {
         return rep.count(key);
     }
+    template <typename K, typename H = HashFcn, typename = typename H::is_transparent,
+              typename E = EqualKey, typename = typename E::is_transparent>
+    iterator find(const K& key) const { return rep.find(key); }
+    template <typename K, typename H = HashFcn, typename = typename H::is_transparent,
+              typename E = EqualKey, typename = typename E::is_transparent>
+    size_type count(const K& key) const { return rep.count(key); }
     size_type erase(const key_type& key) const {
         return rep.erase(key);
     }
     void erase(iterator it) {
         return rep.erase(it);
     }
+
+    using node_type = typename ht::node_type;
+    node_type extract(iterator it) { return rep.extract(it); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    std::pair<iterator, bool> insert(node_type&& nh) { return rep.insert_unique(std::move(nh)); }
+    void merge(unordered_set& source) { rep.merge_unique(source.rep); }
+
     void clear() {
         rep.clear();
     }
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <iso646.h>
+#include "tiny_alloc.h"
+#include "tiny_construct.h"
+#include "tiny_iterator.h"
+
+namespace Tiny
+{
+
+// K == 0 picks as many elements as fit in 256 bytes
+constexpr size_t __unrolled_list_block_size(size_t k, size_t sz) {
+    return k != 0 ? k : (sz < 256 ? 256 / sz : 1);
+}
+
+struct __unrolled_list_node_base
+{
+    using base_ptr = __unrolled_list_node_base*;
+    base_ptr prev;
+    base_ptr next;
+    size_t count;
+};
+
+template <typename T, size_t K>
+struct __unrolled_list_node : public __unrolled_list_node_base
+{
+    alignas(T) unsigned char storage[K * sizeof(T)];
+    T* data() { return reinterpret_cast<T*>(storage); }
+};
+
+template <typename T, typename Ref, typename Ptr, size_t K>
+struct __unrolled_list_iterator
+{
+    using iterator = __unrolled_list_iterator<T, T&, T*, K>;
+    using self = __unrolled_list_iterator<T, Ref, Ptr, K>;
+
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = T;
+    using pointer = Ptr;
+    using reference = Ref;
+    using base_ptr = __unrolled_list_node_base*;
+    using link_type = __unrolled_list_node<T, K>*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    base_ptr node;
+    size_type index;
+
+    __unrolled_list_iterator() { }
+    __unrolled_list_iterator(base_ptr x, size_type i) : node(x), index(i) { }
+    __unrolled_list_iterator(const iterator& x) : node(x.node), index(x.index) { }
+    self& operator=(const self&) = default;
+
+    bool operator==(const self& x) const { return node == x.node and index == x.index; }
+    bool operator!=(const self& x) const { return !(*this == x); }
+    reference operator*() const { return static_cast<link_type>(node)->data()[index]; }
+    pointer operator->() const { return &operator*(); }
+
+    self& operator++() {
+        if (++index == node->count) {
+            node = node->next;
+            index = 0;
+        }
+        return *this;
+    }
+    self operator++(int) {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    self& operator--() {
+        if (index == 0) {
+            node = node->prev;
+            index = node->count;
+        }
+        --index;
+        return *this;
+    }
+    self operator--(int) {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+};
+
+template <typename T, size_t K = 0, typename Alloc = alloc>
+class unrolled_list
+{
+public:
+    static const size_t block_size = __unrolled_list_block_size(K, sizeof(T));
+
+protected:
+    using base_node = __unrolled_list_node_base;
+    using list_node = __unrolled_list_node<T, block_size>;
+    using base_node_allocator = simple_alloc<base_node, Alloc>;
+    using list_node_allocator = simple_alloc<list_node, Alloc>;
+
+public:
+    using value_type = T;
+    using pointer = value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = __unrolled_list_iterator<T, T&, T*, block_size>;
+    using const_iterator = __unrolled_list_iterator<T, const T&, const T*, block_size>;
+    using base_ptr = base_node*;
+    using link_type = list_node*;
+
+protected:
+    base_ptr header;
+    size_type node_count;
+
+    static T* data(base_ptr x) { return static_cast<link_type>(x)->data(); }
+
+    void empty_initialized() {
+        header = base_node_allocator::allocate();
+        header->next = header;
+        header->prev = header;
+        header->count = 0;
+        node_count = 0;
+    }
+    link_type create_node(base_ptr position) {
+        link_type p = list_node_allocator::allocate();
+        p->count = 0;
+        p->next = position;
+        p->prev = position->prev;
+        position->prev->next = p;
+        position->prev = p;
+        return p;
+    }
+    void destroy_node(base_ptr p) {
+        Tiny::destroy(data(p), data(p) + p->count);
+        p->prev->next = p->next;
+        p->next->prev = p->prev;
+        list_node_allocator::deallocate(static_cast<link_type>(p));
+    }
+    void insert_in_node(base_ptr p, size_type index, const T& x);
+    base_ptr split_node(base_ptr p, size_type index);
+
+public:
+    iterator begin() { return iterator(header->next, 0); }
+    iterator end() { return iterator(header, 0); }
+    const_iterator begin() const { return const_iterator(header->next, 0); }
+    const_iterator end() const { return const_iterator(header, 0); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    reference front() { return *begin(); }
+    reference back() { return data(header->prev)[header->prev->count - 1]; }
+    const_reference front() const { return *begin(); }
+    const_reference back() const { return data(header->prev)[header->prev->count - 1]; }
+
+    unrolled_list() { empty_initialized(); }
+    unrolled_list(const unrolled_list&);
+    unrolled_list(unrolled_list&&);
+    ~unrolled_list() {
+        clear();
+        base_node_allocator::deallocate(header);
+    }
+    unrolled_list& operator=(const unrolled_list&);
+    void swap(unrolled_list&);
+
+    iterator insert(iterator position, const T& x);
+    iterator erase(iterator position);
+    void push_back(const T& x);
+    void push_front(const T& x) { insert(begin(), x); }
+    void pop_front() { erase(begin()); }
+    void pop_back() { erase(iterator(header->prev, header->prev->count - 1)); }
+    void clear();
+    void splice(iterator position, unrolled_list& x);
+    void splice(iterator position, unrolled_list& x, iterator first, iterator last);
+};
+
+template <typename T, size_t K, typename Alloc>
+const size_t unrolled_list<T, K, Alloc>::block_size;
+
+template <typename T, size_t K, typename Alloc>
+unrolled_list<T, K, Alloc>::unrolled_list(const unrolled_list& x)
+{
+    empty_initialized();
+    try {
+        for (const T& item : x)
+            push_back(item);
+    }
+    catch (...) {
+        clear();
+        base_node_allocator::deallocate(header);
+        throw;
+    }
+}
+
+template <typename T, size_t K, typename Alloc>
+unrolled_list<T, K, Alloc>::unrolled_list(unrolled_list&& x)
+{
+    empty_initialized();
+    swap(x);
+}
+
+template <typename T, size_t K, typename Alloc>
+unrolled_list<T, K, Alloc>& unrolled_list<T, K, Alloc>::operator=(const unrolled_list& x)
+{
+    if (this == &x) return *this;
+    unrolled_list tmp(x);
+    swap(tmp);
+    return *this;
+}
+
+template <typename T, size_t K, typename Alloc>
+void unrolled_list<T, K, Alloc>::swap(unrolled_list& x)
+{
+    std::swap(header, x.header);
+    std::swap(node_count, x.node_count);
+}
+
+template <typename T, size_t K, typename Alloc>
+void unrolled_list<T, K, Alloc>::clear()
+{
+    while (header->next != header)
+        destroy_node(header->next);
+    node_count = 0;
+}
+
+// p must have room for one more element
+template <typename T, size_t K, typename Alloc>
+void unrolled_list<T, K, Alloc>::insert_in_node(base_ptr p, size_type index, const T& x)
+{
+    T* d = data(p);
+    if (index == p->count) {
+        construct(d + index, x);
+    }
+    else {
+        T tmp(x);
+        construct(d + p->count, std::move(d[p->count - 1]));
+        std::move_backward(d + index, d + p->count - 1, d + p->count);
+        d[index] = std::move(tmp);
+    }
+    p->count++;
+    node_count++;
+}
+
+// moves [index, count) of p into a new node linked right after p
+template <typename T, size_t K, typename Alloc>
+auto unrolled_list<T, K, Alloc>::split_node(base_ptr p, size_type index) -> base_ptr
+{
+    link_type q = create_node(p->next);
+    T* from = data(p);
+    T* to = q->data();
+    size_type n = p->count - index;
+    for (size_type i = 0; i < n; i++)
+        construct(to + i, std::move(from[index + i]));
+    Tiny::destroy(from + index, from + p->count);
+    q->count = n;
+    p->count = index;
+    return q;
+}
+
+template <typename T, size_t K, typename Alloc>
+void unrolled_list<T, K, Alloc>::push_back(const T& x)
+{
+    base_ptr tail = header->prev;
+    if (tail == header or tail->count == block_size)
+        tail = create_node(header);
+    insert_in_node(tail, tail->count, x);
+}
+
+template <typename T, size_t K, typename Alloc>
+auto unrolled_list<T, K, Alloc>::insert(iterator position, const T& x) -> iterator
+{
+    base_ptr p = position.node;
+    size_type index = position.index;
+    if (index == 0 and p->prev != header and p->prev->count < block_size) {
+        p = p->prev;
+        index = p->count;
+    }
+    else if (p == header) {
+        p = create_node(header);
+    }
+    else if (p->count == block_size) {
+        base_ptr q = split_node(p, block_size / 2);
+        if (index > p->count) {
+            index -= p->count;
+            p = q;
+        }
+    }
+    insert_in_node(p, index, x);
+    return iterator(p, index);
+}
+
+// a node that drops below half full absorbs its successor when both fit in one node
+template <typename T, size_t K, typename Alloc>
+auto unrolled_list<T, K, Alloc>::erase(iterator position) -> iterator
+{
+    base_ptr p = position.node;
+    size_type index = position.index;
+    T* d = data(p);
+    std::move(d + index + 1, d + p->count, d + index);
+    Tiny::destroy(d + p->count - 1);
+    p->count--;
+    node_count--;
+
+    if (p->count == 0) {
+        base_ptr next = p->next;
+        destroy_node(p);
+        return iterator(next, 0);
+    }
+
+    base_ptr next = p->next;
+    if (p->count < block_size / 2 and next != header and p->count + next->count <= block_size) {
+        T* from = data(next);
+        for (size_type i = 0; i < next->count; i++)
+            construct(d + p->count + i, std::move(from[i]));
+        p->count += next->count;
+        destroy_node(next);
+    }
+    if (index == p->count)
+        return iterator(p->next, 0);
+    return iterator(p, index);
+}
+
+// O(1) apart from splitting the node at position when it is not a node boundary
+template <typename T, size_t K, typename Alloc>
+void unrolled_list<T, K, Alloc>::splice(iterator position, unrolled_list& x)
+{
+    if (x.empty() or &x == this) return;
+    base_ptr p = position.node;
+    if (position.index != 0)
+        p = split_node(p, position.index);
+
+    base_ptr first = x.header->next;
+    base_ptr last = x.header->prev;
+    first->prev = p->prev;
+    p->prev->next = first;
+    last->next = p;
+    p->prev = last;
+    x.header->next = x.header;
+    x.header->prev = x.header;
+
+    node_count += x.node_count;
+    x.node_count = 0;
+}
+
+// [first, last) is cut on node boundaries and its nodes are relinked; only the
+// boundary nodes are split, the rest move without touching their elements.
+// Splitting invalidates iterators into the split nodes, position included when x is *this
+template <typename T, size_t K, typename Alloc>
+void unrolled_list<T, K, Alloc>::splice(iterator position, unrolled_list& x, iterator first, iterator last)
+{
+    if (first == last) return;
+    if (last.index != 0)
+        last = iterator(x.split_node(last.node, last.index), 0);
+    if (first.index != 0)
+        first = iterator(x.split_node(first.node, first.index), 0);
+    base_ptr p = position.node;
+    if (position.index != 0)
+        p = split_node(p, position.index);
+
+    size_type n = 0;
+    base_ptr tail = first.node;
+    for (; tail->next != last.node; tail = tail->next)
+        n += tail->count;
+    n += tail->count;
+
+    first.node->prev->next = last.node;
+    last.node->prev = first.node->prev;
+    first.node->prev = p->prev;
+    p->prev->next = first.node;
+    tail->next = p;
+    p->prev = tail;
+
+    node_count += n;
+    x.node_count -= n;
+}
+
+}
@@ -3,6 +3,7 @@
 // waiting for copy(), fill(), copy_backward(), max(), swap()
 
 #include <algorithm>
+#include <type_traits>
 #include "tiny_construct.h"
 #include "tiny_alloc.h"
 #include "tiny_uninitialized.h"
@@ -32,7 +33,7 @@ protected:
 
     iterator allocate_and_fill(size_type n, const T& x) {
         iterator result = data_allocator::allocate(n);
-        uninitialized_fill_n(result, n, x);
+        Tiny::uninitialized_fill_n(result, n, x);
         return result;
     }
     void deallocate(void) {
@@ -64,14 +65,18 @@ public:
     explicit vector(size_type n) {  fill_initialize(n, T()); }
     vector(size_type n, const T& value) { fill_initialize(n, value); }
     vector(const vector&);
-    vector(vector&&);
+    vector(vector&&) noexcept;
+    template <typename InputIterator, typename = typename
+              std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    vector(InputIterator first, InputIterator last);
     ~vector() { 
-        destroy(begin(), end());
+        Tiny::destroy(begin(), end());
         deallocate(); 
     }
 
     vector& operator=(const vector&);
-    void swap(vector&);
+    vector& operator=(vector&&) noexcept;
+    void swap(vector&) noexcept;
     void assign(size_type n, const T& x);
     void insert(iterator postion, const T&);
     void insert(iterator postion, size_type, const T&);
@@ -88,20 +93,20 @@ public:
     void pop_back()
     {
         finish--;
-        destroy(finish);
+        Tiny::destroy(finish);
     }
     iterator erase(iterator position)
     {
         if (position + 1 != end())
-            copy(position + 1, finish, position);
+            std::copy(position + 1, finish, position);
         finish--;
-        destroy(finish);
+        Tiny::destroy(finish);
         return position;
     }
     iterator erase(iterator first, iterator last)
     {
         iterator i = std::copy(last, finish, first);
-        destroy(i, finish);
+        Tiny::destroy(i, finish);
         finish -= last - first;
         return first;
     }
@@ -117,7 +122,14 @@ public:
         if (new_len <= capacity())
             return;
         iterator new_start = data_allocator::allocate(new_len);
-        iterator new_finish = uninitialized_copy(start, finish, new_start);
+        iterator new_finish = new_start;
+        try {
+            new_finish = Tiny::uninitialized_move_if_noexcept(start, finish, new_start);
+        }
+        catch (...) {
+            data_allocator::deallocate(new_start, new_len);
+            throw;
+        }
         iterator new_end = new_start + new_len;
         
         clear(), deallocate();
@@ -132,10 +144,36 @@ public:
 
 template <typename T, typename Alloc>
 vector<T, Alloc>::vector(const vector& x)
-    : vector(x.begin(), x.end()) { }
+{
+    start = x.empty() ? nullptr : data_allocator::allocate(x.size());
+    try {
+        finish = Tiny::uninitialized_copy(x.begin(), x.end(), start);
+    }
+    catch (...) {
+        data_allocator::deallocate(start, x.size());
+        throw;
+    }
+    end_of_storage = finish;
+}
 
 template <typename T, typename Alloc>
-vector<T, Alloc>::vector(vector&& x)
+template <typename InputIterator, typename>
+vector<T, Alloc>::vector(InputIterator first, InputIterator last)
+    : start(nullptr), finish(nullptr), end_of_storage(nullptr)
+{
+    try {
+        for (; first != last; ++first)
+            push_back(*first);
+    }
+    catch (...) {
+        Tiny::destroy(begin(), end());
+        deallocate();
+        throw;
+    }
+}
+
+template <typename T, typename Alloc>
+vector<T, Alloc>::vector(vector&& x) noexcept
 {
     start = x.start;
     finish = x.finish;
@@ -148,21 +186,23 @@ vector<T, Alloc>::vector(vector&& x)
 template <typename T, typename Alloc>
 vector<T, Alloc>& vector<T, Alloc>::operator=(const vector& x)
 {
-    clear();
-    iterator first = x.begin();
-    iterator last = x.end();
-    size_type len = distance(first, last);
-    iterator result = data_allocator::allocate(len);
-    start = result;
-    finish = start + len;
-    end_of_storage = finish;
-    for (; first != last; first++)
-        construct(result, *first);
+    if (this == &x) return *this;
+    vector tmp(x);
+    swap(tmp);
+    return *this;
+}
+
+template <typename T, typename Alloc>
+vector<T, Alloc>& vector<T, Alloc>::operator=(vector&& x) noexcept
+{
+    if (this == &x) return *this;
+    vector tmp(std::move(x));
+    swap(tmp);
     return *this;
 }
 
 template <typename T, typename Alloc>
-void vector<T, Alloc>::swap(vector& x)
+void vector<T, Alloc>::swap(vector& x) noexcept
 {
     std::swap(start, x.start);
     std::swap(finish, x.finish);
@@ -173,23 +213,23 @@ template <typename T, typename Alloc>
 void vector<T, Alloc>::assign(size_type n, const T& x)
 {
     if (n <= capacity()) {
-        destroy(begin(), end());
-        finish = uninitialized_fill_n(begin(), n, x);
+        Tiny::destroy(begin(), end());
+        finish = Tiny::uninitialized_fill_n(begin(), n, x);
         return;
     }
 
     iterator new_start = data_allocator::allocate(n);
     iterator new_finish = new_start;
     try {
-        new_finish = uninitialized_fill_n(new_start, n, x);
+        new_finish = Tiny::uninitialized_fill_n(new_start, n, x);
     }
     catch (...) {
-        destroy(new_start, new_finish);
+        Tiny::destroy(new_start, new_finish);
         data_allocator::deallocate(start, end_of_storage - start);
         throw;
     }
 
-    destroy(start, finish);
+    Tiny::destroy(start, finish);
     deallocate();
     start = new_start;
     finish = new_finish;
@@ -198,6 +238,11 @@ void vector<T, Alloc>::assign(size_type n, const T& x)
 
 template <typename T, typename Alloc>
 void vector<T, Alloc>::insert(iterator position, const T& x) {
+    if (finish != end_of_storage and position == finish) {
+        construct(finish, x);
+        finish++;
+        return;
+    }
     if (finish != end_of_storage) {
         construct(finish, *(finish - 1));
         std::copy_backward(position, finish - 1, finish);
@@ -209,20 +254,26 @@ void vector<T, Alloc>::insert(iterator position, const T& x) {
     const size_type old_size = size();
     const size_type len = old_size ? old_size * 2 : 1;
     iterator new_start = data_allocator::allocate(len);
+    iterator new_position = new_start + (position - start);
     iterator new_finish = new_start;
+    // x goes in first: it may alias an element about to be moved from, and
+    // once anything has been moved nothing after it may throw
+    int built = 0;
     try {
-        new_finish = uninitialized_copy(start, position, new_start);
-        construct(new_finish, x);
-        new_finish++;
-        new_finish = uninitialized_copy(position, finish, new_finish);
+        construct(new_position, x);
+        built++;
+        Tiny::uninitialized_move_if_noexcept(start, position, new_start);
+        built++;
+        new_finish = Tiny::uninitialized_move_if_noexcept(position, finish, new_position + 1);
     }
     catch(...) {
-        destroy(new_start, new_finish);
+        if (built > 0) Tiny::destroy(&*new_position);
+        if (built > 1) Tiny::destroy(new_start, new_position);
         data_allocator::deallocate(new_start, len);
         throw;
     }
 
-    destroy(begin(), end());
+    Tiny::destroy(begin(), end());
     deallocate();
     start = new_start;
     finish = new_finish;
@@ -238,16 +289,16 @@ void vector<T, Alloc>::insert(iterator position, size_type n, const T& x)
         const size_type elems_after = finish - position;
         iterator old_finish = finish;
         if (elems_after > n) {
-            uninitialized_copy(finish - n, finish, finish);
+            Tiny::uninitialized_copy(finish - n, finish, finish);
             std::copy_backward(position, finish - n, finish);
             std::fill(position, position + n, x);
             finish += n;
         }
         else
         {
-            uninitialized_fill_n(finish, n - elems_after, x);
+            Tiny::uninitialized_fill_n(finish, n - elems_after, x);
             finish += n - elems_after;
-            uninitialized_copy(position, old_finish, finish);
+            Tiny::uninitialized_copy(position, old_finish, finish);
             finish += elems_after;
             std::fill(position, old_finish, x);
         }
@@ -257,19 +308,24 @@ void vector<T, Alloc>::insert(iterator position, size_type n, const T& x)
     const size_type old_size = size();
     const size_type len = old_size + std::max(old_size, n);
     iterator new_start = data_allocator::allocate(len);
-    iterator new_finish = start;
+    iterator new_position = new_start + (position - start);
+    iterator new_finish = new_start;
+    int built = 0;
     try {
-        new_finish = uninitialized_copy(start, position, new_start);
-        new_finish = uninitialized_fill_n(new_finish, n, x);
-        new_finish = uninitialized_copy(position, finish, new_finish);
+        Tiny::uninitialized_fill_n(new_position, n, x);
+        built++;
+        Tiny::uninitialized_move_if_noexcept(start, position, new_start);
+        built++;
+        new_finish = Tiny::uninitialized_move_if_noexcept(position, finish, new_position + n);
     }
     catch (...) {
-        destroy(new_start, new_finish);
+        if (built > 0) Tiny::destroy(new_position, new_position + n);
+        if (built > 1) Tiny::destroy(new_start, new_position);
         data_allocator::deallocate(new_start, len);
         throw;
     }
 
-    destroy(start, finish);
+    Tiny::destroy(start, finish);
     deallocate();
     start = new_start;
     finish = new_finish;
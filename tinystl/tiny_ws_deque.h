@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include "tiny_alloc.h"
+#include "tiny_circular_buffer.h"   // for __cb_capacity()
+#include "tiny_sync.h"
+
+namespace Tiny
+{
+
+// Chase-Lev work-stealing deque with the memory orders of Le et al. (PPoPP 2013).
+// The owner pushes and pops at bottom, thieves steal at top. Slots are atomics,
+// so T must be trivially copyable (typically a task pointer).
+
+template <typename T>
+struct __ws_array
+{
+    using self = __ws_array<T>;
+    size_t mask;
+    self* prev;
+    std::atomic<T> buf[1];
+
+    static size_t bytes(size_t n) { return sizeof(self) + (n - 1) * sizeof(std::atomic<T>); }
+    T load(ptrdiff_t i) const { return buf[i & mask].load(std::memory_order_relaxed); }
+    void store(ptrdiff_t i, T x) { buf[i & mask].store(x, std::memory_order_relaxed); }
+};
+
+template <typename T, typename Alloc = malloc_alloc>
+class ws_deque
+{
+    static_assert(std::is_trivially_copyable<T>::value, "ws_deque requires a trivially copyable T");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+protected:
+    using array = __ws_array<T>;
+
+    alignas(__cache_line_size) std::atomic<difference_type> top;
+    alignas(__cache_line_size) std::atomic<difference_type> bottom;
+    std::atomic<array*> active;
+
+    static array* create_array(size_type n, array* prev) {
+        array* a = static_cast<array*>(Alloc::allocate(array::bytes(n)));
+        a->mask = n - 1;
+        a->prev = prev;
+        for (size_type i = 0; i < n; i++)
+            new(&a->buf[i]) std::atomic<T>();
+        return a;
+    }
+    static void destroy_array(array* a) {
+        Alloc::deallocate(a, array::bytes(a->mask + 1));
+    }
+    array* grow(array* a, difference_type t, difference_type b);
+
+public:
+    explicit ws_deque(size_type n = 64) : top(0), bottom(0) {
+        active.store(create_array(__cb_capacity(n), nullptr), std::memory_order_relaxed);
+    }
+    ws_deque(const ws_deque&) = delete;
+    ws_deque& operator=(const ws_deque&) = delete;
+    ~ws_deque() {
+        array* a = active.load(std::memory_order_relaxed);
+        while (a != nullptr) {
+            array* prev = a->prev;
+            destroy_array(a);
+            a = prev;
+        }
+    }
+
+    size_type capacity() const { return active.load(std::memory_order_relaxed)->mask + 1; }
+    size_type size() const {
+        difference_type b = bottom.load(std::memory_order_relaxed);
+        difference_type t = top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+    bool empty() const { return size() == 0; }
+
+    // owner only
+    void push(const T&);
+    bool pop(T&);
+    // any thread
+    bool steal(T&);
+};
+
+// old arrays stay alive until destruction because a thief may still be reading one
+
+template <typename T, typename Alloc>
+auto ws_deque<T, Alloc>::grow(array* a, difference_type t, difference_type b) -> array*
+{
+    array* bigger = create_array(2 * (a->mask + 1), a);
+    for (difference_type i = t; i < b; i++)
+        bigger->store(i, a->load(i));
+    active.store(bigger, std::memory_order_release);
+    return bigger;
+}
+
+template <typename T, typename Alloc>
+void ws_deque<T, Alloc>::push(const T& x)
+{
+    difference_type b = bottom.load(std::memory_order_relaxed);
+    difference_type t = top.load(std::memory_order_acquire);
+    array* a = active.load(std::memory_order_relaxed);
+    if (b - t > difference_type(a->mask))
+        a = grow(a, t, b);
+    a->store(b, x);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+template <typename T, typename Alloc>
+bool ws_deque<T, Alloc>::pop(T& x)
+{
+    difference_type b = bottom.load(std::memory_order_relaxed) - 1;
+    array* a = active.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    difference_type t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    x = a->load(b);
+    if (t != b) return true;
+
+    // last element: race against thieves for it
+    bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return won;
+}
+
+template <typename T, typename Alloc>
+bool ws_deque<T, Alloc>::steal(T& x)
+{
+    difference_type t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    difference_type b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return false;
+
+    array* a = active.load(std::memory_order_acquire);
+    T tmp = a->load(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed))
+        return false;
+    x = tmp;
+    return true;
+}
+
+}